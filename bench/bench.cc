@@ -0,0 +1,239 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <string>
+
+#include "matrix_batch.h"
+#include "matrix_io.h"
+#include "matrix_memory.h"
+#include "matrix_oop.h"
+
+namespace {
+
+const int kMinSize = 2;
+const int kMaxSize = 2048;
+// Matrices per batch in the batched benchmarks.
+const int kBatchCount = 4096;
+
+// Deterministic, diagonally dominant fill so every size is invertible.
+Matrix MakeMatrix(int size) {
+  Matrix result(size, size);
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) {
+      result(i, j) = (i == j) ? size : ((i * 7 + j * 13) % 11) / 11.0;
+    }
+  }
+  return result;
+}
+
+void SetFlops(benchmark::State &state, double flops) {
+  state.counters["FLOPS"] =
+      benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate,
+                         benchmark::Counter::kIs1000);
+}
+
+void SetBytes(benchmark::State &state, double bytes) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+void BM_Construct(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    Matrix matrix(size, size);
+    benchmark::DoNotOptimize(matrix.Data());
+  }
+  SetBytes(state, 8.0 * size * size);
+}
+
+void BM_ConstructPool(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  memory::PoolResource pool;
+  memory::ScopedResource scope(&pool);
+  for (auto _ : state) {
+    Matrix matrix(size, size);
+    benchmark::DoNotOptimize(matrix.Data());
+  }
+  SetBytes(state, 8.0 * size * size);
+}
+
+void BM_ConstructArena(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  memory::ArenaResource arena;
+  memory::ScopedResource scope(&arena);
+  for (auto _ : state) {
+    {
+      Matrix matrix(size, size);
+      benchmark::DoNotOptimize(matrix.Data());
+    }
+    arena.Release();
+  }
+  SetBytes(state, 8.0 * size * size);
+}
+
+void BM_Copy(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  Matrix source = MakeMatrix(size);
+  for (auto _ : state) {
+    Matrix copy(source);
+    benchmark::DoNotOptimize(copy.Data());
+  }
+  SetBytes(state, 16.0 * size * size);
+}
+
+void BM_Move(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  Matrix source = MakeMatrix(size);
+  for (auto _ : state) {
+    Matrix moved(std::move(source));
+    benchmark::DoNotOptimize(moved.Data());
+    source = std::move(moved);
+  }
+}
+
+void BM_AddAssign(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  Matrix left = MakeMatrix(size);
+  Matrix right = MakeMatrix(size);
+  for (auto _ : state) {
+    left += right;
+    benchmark::ClobberMemory();
+  }
+  SetBytes(state, 24.0 * size * size);
+  SetFlops(state, 1.0 * size * size);
+}
+
+void BM_Multiply(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  Matrix left = MakeMatrix(size);
+  Matrix right = MakeMatrix(size);
+  for (auto _ : state) {
+    Matrix product = left * right;
+    benchmark::DoNotOptimize(product.Data());
+  }
+  SetFlops(state, 2.0 * size * size * size);
+}
+
+void BM_Transpose(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  Matrix matrix = MakeMatrix(size);
+  for (auto _ : state) {
+    Matrix transposed = matrix.Transpose();
+    benchmark::DoNotOptimize(transposed.Data());
+  }
+  SetBytes(state, 16.0 * size * size);
+}
+
+void BM_Determinant(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  Matrix matrix = MakeMatrix(size);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(matrix.Determinant());
+  }
+  SetFlops(state, 2.0 / 3.0 * size * size * size);
+}
+
+void BM_InverseMatrix(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  Matrix matrix = MakeMatrix(size);
+  for (auto _ : state) {
+    Matrix inverse = matrix.InverseMatrix();
+    benchmark::DoNotOptimize(inverse.Data());
+  }
+  SetFlops(state, 8.0 / 3.0 * size * size * size);
+}
+
+void BM_CalcComplements(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  Matrix matrix = MakeMatrix(size);
+  for (auto _ : state) {
+    Matrix complements = matrix.CalcComplements();
+    benchmark::DoNotOptimize(complements.Data());
+  }
+  SetFlops(state, 8.0 / 3.0 * size * size * size);
+}
+
+MatrixBatch MakeBatch(int count, int size) {
+  MatrixBatch result(count, size, size);
+  for (int b = 0; b < count; ++b) {
+    result.Set(b, MakeMatrix(size));
+    result(b, 0, size - 1) += b % 7;
+  }
+  return result;
+}
+
+void BM_BatchDeterminant(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  MatrixBatch batch = MakeBatch(kBatchCount, size);
+  for (auto _ : state) {
+    std::vector<double> determinants = batch.Determinant();
+    benchmark::DoNotOptimize(determinants.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchCount);
+}
+
+void BM_BatchInverse(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  MatrixBatch batch = MakeBatch(kBatchCount, size);
+  for (auto _ : state) {
+    MatrixBatch inverse = batch.InverseMatrix();
+    benchmark::DoNotOptimize(&inverse(0, 0, 0));
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchCount);
+}
+
+void BM_WriteText(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  Matrix matrix = MakeMatrix(size);
+  std::size_t bytes = 0;
+  for (auto _ : state) {
+    std::ostringstream out;
+    io::WriteText(matrix, out);
+    bytes = out.str().size();
+  }
+  SetBytes(state, static_cast<double>(bytes));
+}
+
+void BM_ReadText(benchmark::State &state) {
+  const int size = static_cast<int>(state.range(0));
+  std::ostringstream out;
+  io::WriteText(MakeMatrix(size), out);
+  const std::string text = out.str();
+  for (auto _ : state) {
+    std::istringstream in(text);
+    Matrix matrix = io::ReadText<double>(in);
+    benchmark::DoNotOptimize(matrix.Data());
+  }
+  SetBytes(state, static_cast<double>(text.size()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_Construct)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_ConstructPool)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_ConstructArena)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_Copy)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_Move)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_AddAssign)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_Multiply)
+    ->RangeMultiplier(2)
+    ->Range(kMinSize, kMaxSize)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Transpose)->RangeMultiplier(2)->Range(kMinSize, kMaxSize);
+BENCHMARK(BM_Determinant)
+    ->RangeMultiplier(2)
+    ->Range(kMinSize, kMaxSize)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_InverseMatrix)
+    ->RangeMultiplier(2)
+    ->Range(kMinSize, kMaxSize)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CalcComplements)
+    ->RangeMultiplier(2)
+    ->Range(kMinSize, kMaxSize)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BatchDeterminant)->DenseRange(3, 8);
+BENCHMARK(BM_BatchInverse)->DenseRange(3, 8);
+BENCHMARK(BM_WriteText)->Arg(1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReadText)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,352 @@
+#include "matrix_batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+
+#include "matrix_threads.h"
+
+namespace {
+
+// Matrices processed together by one elimination: enough lanes to fill the
+// vector units several times over, while the 8x8 factors and right-hand
+// sides of a chunk (32 KiB each) stay in L2.
+const int kBatchLanes = 64;
+
+// Per-thread scratch for one chunk, reused across chunks and calls so the
+// batched operations do not allocate per chunk.
+class Workspace {
+ public:
+  Workspace() : factors_(), rhs_(), pivots_() {}
+
+  double* Factors(int elements) { return Resize(factors_, elements); }
+  double* Rhs(int elements) { return Resize(rhs_, elements); }
+  int* Pivots(int rows) { return Resize(pivots_, rows); }
+
+ private:
+  std::vector<double> factors_;
+  std::vector<double> rhs_;
+  std::vector<int> pivots_;
+
+  template <class V>
+  static typename V::value_type* Resize(V& buffer, int elements) {
+    buffer.resize(static_cast<size_t>(elements) * kBatchLanes);
+    return buffer.data();
+  }
+};
+
+// Calls body(begin, lanes) for consecutive chunks of at most kBatchLanes
+// matrices covering [0, count), spread over the library thread pool.
+void ForEachChunk(int count, const std::function<void(int, int)>& body) {
+  threads::ParallelFor(count, kBatchLanes, [&](int begin, int end) {
+    for (int chunk = begin; chunk < end; chunk += kBatchLanes) {
+      body(chunk, std::min(kBatchLanes, end - chunk));
+    }
+  });
+}
+
+// Position of interleaved element e, that is i * cols + j, of matrix 0 in a
+// batch of count matrices. Computed in std::ptrdiff_t: batches of a few
+// million small matrices already pass INT_MAX elements.
+std::ptrdiff_t Offset(int e, int count) {
+  return static_cast<std::ptrdiff_t>(e) * count;
+}
+
+// Copies lanes [begin, begin + lanes) of `elements` interleaved elements with
+// stride count into dst, where they get stride lanes.
+void Gather(const double* src, int elements, int count, int begin, int lanes,
+            double* dst) {
+  for (int e = 0; e < elements; ++e) {
+    const double* from = src + Offset(e, count) + begin;
+    std::copy(from, from + lanes, dst + e * lanes);
+  }
+}
+
+void Scatter(const double* src, int elements, int count, int begin, int lanes,
+             double* dst) {
+  for (int e = 0; e < elements; ++e) {
+    std::copy(src + e * lanes, src + (e + 1) * lanes,
+              dst + Offset(e, count) + begin);
+  }
+}
+
+// LU factorization with partial pivoting, P * A = L * U, of `lanes` n x n
+// matrices interleaved with stride lanes, in place. Each lane picks its own
+// pivots; pivots[k * lanes + l] is the row swapped with row k in lane l and
+// sign[l] the determinant of the permutation. Returns true when some lane has
+// a pivot below kEpsilon, the singularity test of LuFactor.
+bool Factorize(int n, int lanes, double* a, int* pivots, double* sign) {
+  double best[kBatchLanes];
+  std::fill(sign, sign + lanes, 1.0);
+  for (int k = 0; k < n; ++k) {
+    const double* diagonal = a + (k * n + k) * lanes;
+    int* pivot = pivots + k * lanes;
+    for (int l = 0; l < lanes; ++l) {
+      best[l] = std::fabs(diagonal[l]);
+      pivot[l] = k;
+    }
+    for (int i = k + 1; i < n; ++i) {
+      const double* x = a + (i * n + k) * lanes;
+      for (int l = 0; l < lanes; ++l) {
+        if (std::fabs(x[l]) > best[l]) {
+          best[l] = std::fabs(x[l]);
+          pivot[l] = i;
+        }
+      }
+    }
+    for (int l = 0; l < lanes; ++l) {
+      if (pivot[l] != k) {
+        sign[l] = -sign[l];
+        for (int j = 0; j < n; ++j) {
+          std::swap(a[(k * n + j) * lanes + l],
+                    a[(pivot[l] * n + j) * lanes + l]);
+        }
+      }
+    }
+    const double* u = a + k * n * lanes;
+    for (int i = k + 1; i < n; ++i) {
+      double* row = a + i * n * lanes;
+      double* factor = row + k * lanes;
+      for (int l = 0; l < lanes; ++l) {
+        const double u_kk = u[k * lanes + l];
+        factor[l] = (u_kk != 0) ? factor[l] / u_kk : 0;
+      }
+      for (int j = k + 1; j < n; ++j) {
+        double* x = row + j * lanes;
+        const double* y = u + j * lanes;
+        for (int l = 0; l < lanes; ++l) {
+          x[l] -= factor[l] * y[l];
+        }
+      }
+    }
+  }
+  bool singular = false;
+  for (int k = 0; k < n; ++k) {
+    const double* diagonal = a + (k * n + k) * lanes;
+    for (int l = 0; l < lanes; ++l) {
+      singular = singular || std::fabs(diagonal[l]) < kEpsilon;
+    }
+  }
+  return singular;
+}
+
+// Overwrites the n x m right-hand sides b (interleaved with stride lanes)
+// with the solutions of A * X = b, given the output of Factorize.
+void SolveFactorized(int n, int m, int lanes, const double* a,
+                     const int* pivots, double* b) {
+  for (int k = 0; k < n; ++k) {
+    const int* pivot = pivots + k * lanes;
+    for (int l = 0; l < lanes; ++l) {
+      if (pivot[l] != k) {
+        for (int j = 0; j < m; ++j) {
+          std::swap(b[(k * m + j) * lanes + l],
+                    b[(pivot[l] * m + j) * lanes + l]);
+        }
+      }
+    }
+  }
+  for (int i = 1; i < n; ++i) {
+    for (int k = 0; k < i; ++k) {
+      const double* l_ik = a + (i * n + k) * lanes;
+      for (int j = 0; j < m; ++j) {
+        double* x = b + (i * m + j) * lanes;
+        const double* y = b + (k * m + j) * lanes;
+        for (int l = 0; l < lanes; ++l) {
+          x[l] -= l_ik[l] * y[l];
+        }
+      }
+    }
+  }
+  for (int i = n - 1; i >= 0; --i) {
+    for (int k = i + 1; k < n; ++k) {
+      const double* u_ik = a + (i * n + k) * lanes;
+      for (int j = 0; j < m; ++j) {
+        double* x = b + (i * m + j) * lanes;
+        const double* y = b + (k * m + j) * lanes;
+        for (int l = 0; l < lanes; ++l) {
+          x[l] -= u_ik[l] * y[l];
+        }
+      }
+    }
+    const double* u_ii = a + (i * n + i) * lanes;
+    for (int j = 0; j < m; ++j) {
+      double* x = b + (i * m + j) * lanes;
+      for (int l = 0; l < lanes; ++l) {
+        x[l] /= u_ii[l];
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// --------------------- CREATION ---------------------
+
+MatrixBatch::MatrixBatch() noexcept
+    : count_(0), rows_(0), cols_(0), data_() {}
+
+MatrixBatch::MatrixBatch(int count, int rows, int cols)
+    : count_(count), rows_(rows), cols_(cols), data_() {
+  if (count_ < 0) {
+    throw std::invalid_argument("Number of matrices less than 0.");
+  }
+  if (rows_ < 0) {
+    throw std::invalid_argument("Number of rows less than 0.");
+  }
+  if (cols_ < 0) {
+    throw std::invalid_argument("Number of columns less than 0.");
+  }
+  if (rows_ > 0 && cols_ > 0 &&
+      static_cast<size_t>(count_) >
+          data_.max_size() / static_cast<size_t>(rows_) / cols_) {
+    throw std::invalid_argument("Matrix too large.");
+  }
+  data_.assign(static_cast<size_t>(count_) * rows_ * cols_, 0.0);
+}
+
+// --------------------- ACCESSORS ---------------------
+
+int MatrixBatch::GetCount() const noexcept { return count_; }
+
+int MatrixBatch::GetRows() const noexcept { return rows_; }
+
+int MatrixBatch::GetCols() const noexcept { return cols_; }
+
+double& MatrixBatch::operator()(int b, int i, int j) {
+  return data_[Index(b, i, j)];
+}
+
+const double& MatrixBatch::operator()(int b, int i, int j) const {
+  return data_[Index(b, i, j)];
+}
+
+Matrix MatrixBatch::Get(int b) const {
+  Matrix result(rows_, cols_);
+  for (int i = 0; i < rows_; ++i) {
+    for (int j = 0; j < cols_; ++j) {
+      result(i, j) = data_[Index(b, i, j)];
+    }
+  }
+  return result;
+}
+
+void MatrixBatch::Set(int b, const Matrix& matrix) {
+  if (matrix.GetRows() != rows_ || matrix.GetCols() != cols_) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  for (int i = 0; i < rows_; ++i) {
+    for (int j = 0; j < cols_; ++j) {
+      data_[Index(b, i, j)] = matrix(i, j);
+    }
+  }
+}
+
+// --------------------- OPERATIONS ---------------------
+
+std::vector<double> MatrixBatch::Determinant() const {
+  if (rows_ != cols_) {
+    throw std::invalid_argument("The matrix is not square.");
+  }
+  const int n = rows_;
+  std::vector<double> result(count_, n > 0 ? 1.0 : 0.0);
+  if (n == 0) return result;
+  ForEachChunk(count_, [&](int begin, int lanes) {
+    thread_local Workspace work;
+    double* a = work.Factors(n * n);
+    double* det = result.data() + begin;
+    Gather(data_.data(), n * n, count_, begin, lanes, a);
+    Factorize(n, lanes, a, work.Pivots(n), det);
+    for (int k = 0; k < n; ++k) {
+      const double* diagonal = a + (k * n + k) * lanes;
+      for (int l = 0; l < lanes; ++l) {
+        det[l] *= diagonal[l];
+      }
+    }
+  });
+  return result;
+}
+
+MatrixBatch MatrixBatch::InverseMatrix() const {
+  if (rows_ != cols_) {
+    throw std::invalid_argument("The matrix is not square.");
+  }
+  MatrixBatch identity(count_, rows_, rows_);
+  for (int i = 0; i < rows_; ++i) {
+    std::fill_n(identity.data_.begin() + Offset(i * rows_ + i, count_), count_,
+                1.0);
+  }
+  return Solve(identity);
+}
+
+MatrixBatch MatrixBatch::operator*(const MatrixBatch& other) const {
+  if (count_ != other.count_) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  if (cols_ != other.rows_) {
+    throw std::invalid_argument(
+        "The number of columns of the first matrix is not equal to the number "
+        "of rows of the second matrix.");
+  }
+  const int n = other.cols_;
+  MatrixBatch result(count_, rows_, n);
+  ForEachChunk(count_, [&](int begin, int lanes) {
+    for (int i = 0; i < rows_; ++i) {
+      for (int j = 0; j < n; ++j) {
+        double* c = result.data_.data() + Offset(i * n + j, count_) + begin;
+        for (int p = 0; p < cols_; ++p) {
+          const double* a =
+              data_.data() + Offset(i * cols_ + p, count_) + begin;
+          const double* b =
+              other.data_.data() + Offset(p * n + j, count_) + begin;
+          for (int l = 0; l < lanes; ++l) {
+            c[l] += a[l] * b[l];
+          }
+        }
+      }
+    }
+  });
+  return result;
+}
+
+MatrixBatch MatrixBatch::Solve(const MatrixBatch& rhs) const {
+  if (rows_ != cols_) {
+    throw std::invalid_argument("The matrix is not square.");
+  }
+  if (count_ != rhs.count_ || rows_ != rhs.rows_) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  const int n = rows_;
+  const int m = rhs.cols_;
+  MatrixBatch result(count_, n, m);
+  std::atomic<bool> singular(false);
+  ForEachChunk(count_, [&](int begin, int lanes) {
+    thread_local Workspace work;
+    double* a = work.Factors(n * n);
+    double* b = work.Rhs(n * m);
+    int* pivots = work.Pivots(n);
+    double sign[kBatchLanes];
+    Gather(data_.data(), n * n, count_, begin, lanes, a);
+    if (Factorize(n, lanes, a, pivots, sign)) {
+      singular = true;
+    } else {
+      Gather(rhs.data_.data(), n * m, count_, begin, lanes, b);
+      SolveFactorized(n, m, lanes, a, pivots, b);
+      Scatter(b, n * m, count_, begin, lanes, result.data_.data());
+    }
+  });
+  if (singular) {
+    throw std::invalid_argument("The matrix determinant is 0.");
+  }
+  return result;
+}
+
+// --------------------- UTILS ---------------------
+
+std::ptrdiff_t MatrixBatch::Index(int b, int i, int j) const {
+  if (b < 0 || b >= count_ || i < 0 || i >= rows_ || j < 0 || j >= cols_) {
+    throw std::out_of_range("Index out of range.");
+  }
+  return Offset(i * cols_ + j, count_) + b;
+}
@@ -0,0 +1,47 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_BATCH_H_
+#define _MATRIX_OOP_LIB__MATRIX_BATCH_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "matrix_oop.h"
+
+// GetCount() matrices of one shape stored interleaved: element (i, j) of
+// every matrix is contiguous, at [(i * cols + j) * count + b] for matrix b.
+// Batched operations run the same elimination steps for all matrices at once
+// with the batch index as the innermost, vectorized loop, and split the batch
+// across the library thread pool. Meant for many small matrices (say up to
+// 8x8), where per-object calls are dominated by allocation and call overhead.
+class MatrixBatch {
+ public:
+  MatrixBatch() noexcept;
+  // Throws std::invalid_argument when count * rows * cols doubles do not fit
+  // in one std::vector.
+  MatrixBatch(int count, int rows, int cols);
+
+  int GetCount() const noexcept;
+  int GetRows() const noexcept;
+  int GetCols() const noexcept;
+
+  // Element (i, j) of matrix b.
+  double &operator()(int b, int i, int j);
+  const double &operator()(int b, int i, int j) const;
+
+  Matrix Get(int b) const;
+  void Set(int b, const Matrix &matrix);
+
+  std::vector<double> Determinant() const;
+  MatrixBatch InverseMatrix() const;
+  // Matrix b of the result is (*this)[b] * other[b].
+  MatrixBatch operator*(const MatrixBatch &other) const;
+  // Matrix b of the result solves (*this)[b] * X = rhs[b].
+  MatrixBatch Solve(const MatrixBatch &rhs) const;
+
+ private:
+  int count_, rows_, cols_;
+  std::vector<double> data_;
+
+  std::ptrdiff_t Index(int b, int i, int j) const;
+};
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_BATCH_H_
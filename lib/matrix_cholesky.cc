@@ -0,0 +1,204 @@
+#include "matrix_cholesky.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+
+#include "matrix_gemm.h"
+#include "matrix_threads.h"
+
+namespace {
+
+// Rows of U factored between two trailing GEMM updates, and height of the
+// block rows the upper triangular trailing update is split into.
+const int kPanel = 64;
+// Smallest column range of a right-hand side handed to one thread.
+const int kSolveColumns = 64;
+
+template <class R>
+R Conjugate(const R& x) {
+  return x;
+}
+
+template <class R>
+std::complex<R> Conjugate(const std::complex<R>& x) {
+  return std::conj(x);
+}
+
+}  // namespace
+
+// --------------------- CREATION ---------------------
+
+template <class T>
+BasicCholeskyFactor<T>::BasicCholeskyFactor() noexcept : u_() {}
+
+// Right-looking blocked factorization on the rows of U, which are contiguous
+// in the row-major buffer. Each kPanel-high block row is factored with
+// row axpys across the full width, then the trailing matrix is updated by
+// A22 -= U12^H * U12 through the GEMM kernel. Only block rows of the upper
+// triangle are updated, which halves the trailing flops against LU, and the
+// block rows run in parallel.
+template <class T>
+BasicCholeskyFactor<T>::BasicCholeskyFactor(const BasicMatrix<T>& matrix)
+    : u_(matrix) {
+  const int n = matrix.GetRows();
+  if (n != matrix.GetCols()) {
+    throw std::invalid_argument("The matrix is not square.");
+  }
+  T* a = u_.Data();
+  // Pivots are judged against the largest diagonal entry of A, so that a
+  // semidefinite matrix is rejected whatever its scale instead of producing
+  // huge or infinite factors, as LuFactor::IsSingular does with its pivots.
+  Real max_diagonal = 0;
+  for (int k = 0; k < n; ++k) {
+    max_diagonal = std::max(max_diagonal, std::real(a[k * n + k]));
+  }
+  const Real threshold = MatrixTraits<T>::kTolerance * max_diagonal;
+  // U12^H of the current block row, stored contiguously for the GEMM.
+  std::vector<T> panel;
+  for (int kb = 0; kb < n; kb += kPanel) {
+    const int panel_end = std::min(kb + kPanel, n);
+    for (int k = kb; k < panel_end; ++k) {
+      T* row = a + k * n;
+      const Real diagonal = std::real(row[k]);
+      if (!(diagonal > threshold)) {
+        throw std::invalid_argument("The matrix is not positive definite.");
+      }
+      const Real u_kk = std::sqrt(diagonal);
+      const Real inverse = 1 / u_kk;
+      row[k] = u_kk;
+      for (int j = k + 1; j < n; ++j) {
+        row[j] *= inverse;
+      }
+      for (int i = k + 1; i < panel_end; ++i) {
+        const T factor = Conjugate(row[i]);
+        T* target = a + i * n;
+        for (int j = i; j < n; ++j) {
+          target[j] -= factor * row[j];
+        }
+      }
+    }
+    if (panel_end == n) break;
+    const int depth = panel_end - kb;
+    const int width = n - panel_end;
+    panel.resize(static_cast<size_t>(width) * depth);
+    for (int p = 0; p < depth; ++p) {
+      const T* u = a + (kb + p) * n + panel_end;
+      for (int i = 0; i < width; ++i) {
+        panel[i * depth + p] = Conjugate(u[i]);
+      }
+    }
+    // Block rows of the trailing triangle are independent GEMMs whose width
+    // shrinks down the matrix. Block row b is paired with the one mirrored
+    // from the end, so that every pair carries about the same work, and the
+    // pairs are shared out over the thread pool.
+    const int blocks = (width + kPanel - 1) / kPanel;
+    auto update = [&](int block) {
+      const int ib = block * kPanel;
+      const int rows = std::min(kPanel, width - ib);
+      gemm::Multiply(rows, width - ib, depth, T(-1), panel.data() + ib * depth,
+                     depth, a + kb * n + panel_end + ib, n,
+                     a + (panel_end + ib) * n + panel_end + ib, n);
+    };
+    threads::ParallelFor((blocks + 1) / 2, 1, [&](int begin, int end) {
+      for (int pair = begin; pair < end; ++pair) {
+        update(pair);
+        if (blocks - 1 - pair != pair) update(blocks - 1 - pair);
+      }
+    });
+  }
+  for (int i = 1; i < n; ++i) {
+    std::fill(a + i * n, a + i * n + i, T());
+  }
+}
+
+// --------------------- ACCESSORS ---------------------
+
+template <class T>
+const BasicMatrix<T>& BasicCholeskyFactor<T>::GetU() const noexcept {
+  return u_;
+}
+
+template <class T>
+int BasicCholeskyFactor<T>::GetSize() const noexcept {
+  return u_.GetRows();
+}
+
+// --------------------- OPERATIONS ---------------------
+
+template <class T>
+T BasicCholeskyFactor<T>::Determinant() const noexcept {
+  const int n = u_.GetRows();
+  const T* u = u_.Data();
+  T result = 1;
+  for (int k = 0; k < n; ++k) {
+    result *= u[k * n + k] * u[k * n + k];
+  }
+  return result;
+}
+
+// Forward substitution with U^H, whose column k is row k of U conjugated,
+// then back substitution with U. Both update whole rows of the right-hand
+// side, and threads take column ranges as in LuFactor.
+template <class T>
+BasicMatrix<T> BasicCholeskyFactor<T>::Solve(const BasicMatrix<T>& rhs) const {
+  const int n = u_.GetRows();
+  if (rhs.GetRows() != n) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  BasicMatrix<T> result(rhs);
+  const int m = result.GetCols();
+  const T* u = u_.Data();
+  T* x = result.Data();
+  threads::ParallelFor(m, kSolveColumns, [&](int begin, int end) {
+    for (int k = 0; k < n; ++k) {
+      const T* u_row = u + k * n;
+      T* x_k = x + k * m;
+      const T inverse = T(1) / u_row[k];
+      for (int j = begin; j < end; ++j) {
+        x_k[j] *= inverse;
+      }
+      for (int i = k + 1; i < n; ++i) {
+        const T factor = Conjugate(u_row[i]);
+        if (factor == T()) continue;
+        T* x_i = x + i * m;
+        for (int j = begin; j < end; ++j) {
+          x_i[j] -= factor * x_k[j];
+        }
+      }
+    }
+    for (int i = n - 1; i >= 0; --i) {
+      const T* u_row = u + i * n;
+      T* x_i = x + i * m;
+      for (int k = i + 1; k < n; ++k) {
+        const T u_ik = u_row[k];
+        if (u_ik == T()) continue;
+        const T* x_k = x + k * m;
+        for (int j = begin; j < end; ++j) {
+          x_i[j] -= u_ik * x_k[j];
+        }
+      }
+      const T inverse = T(1) / u_row[i];
+      for (int j = begin; j < end; ++j) {
+        x_i[j] *= inverse;
+      }
+    }
+  });
+  return result;
+}
+
+template <class T>
+BasicMatrix<T> SolveSpd(const BasicMatrix<T>& a, const BasicMatrix<T>& b) {
+  return BasicCholeskyFactor<T>(a).Solve(b);
+}
+
+template FloatMatrix SolveSpd<float>(const FloatMatrix&, const FloatMatrix&);
+template Matrix SolveSpd<double>(const Matrix&, const Matrix&);
+template ComplexMatrix SolveSpd<std::complex<double>>(const ComplexMatrix&,
+                                                      const ComplexMatrix&);
+
+template class BasicCholeskyFactor<float>;
+template class BasicCholeskyFactor<double>;
+template class BasicCholeskyFactor<std::complex<double>>;
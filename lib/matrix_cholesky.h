@@ -0,0 +1,44 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_CHOLESKY_H_
+#define _MATRIX_OOP_LIB__MATRIX_CHOLESKY_H_
+
+#include "matrix_oop.h"
+
+// Cholesky factorization A = U^H * U of a symmetric (Hermitian for complex)
+// positive definite matrix, with U upper triangular and a positive real
+// diagonal. Only the upper triangle of A is read. Takes about half the flops
+// of LuFactor and needs no pivoting; a factor can be kept to solve against
+// many right-hand sides. Instantiated for float, double and
+// std::complex<double>.
+template <class T>
+class BasicCholeskyFactor {
+ public:
+  BasicCholeskyFactor() noexcept;
+  // Throws std::invalid_argument when matrix is not square or not positive
+  // definite, counting as semidefinite any pivot of the elimination at most
+  // MatrixTraits<T>::kTolerance times the largest diagonal entry of matrix.
+  explicit BasicCholeskyFactor(const BasicMatrix<T> &matrix);
+
+  // U, zero below the diagonal.
+  const BasicMatrix<T> &GetU() const noexcept;
+  int GetSize() const noexcept;
+  T Determinant() const noexcept;
+  // Solution X of A * X = rhs for any number of right-hand side columns.
+  BasicMatrix<T> Solve(const BasicMatrix<T> &rhs) const;
+
+ private:
+  using Real = typename MatrixTraits<T>::Real;
+
+  BasicMatrix<T> u_;
+};
+
+// Solution X of A * X = B for a symmetric positive definite A.
+template <class T>
+BasicMatrix<T> SolveSpd(const BasicMatrix<T> &a, const BasicMatrix<T> &b);
+
+using CholeskyFactor = BasicCholeskyFactor<double>;
+
+extern template class BasicCholeskyFactor<float>;
+extern template class BasicCholeskyFactor<double>;
+extern template class BasicCholeskyFactor<std::complex<double>>;
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_CHOLESKY_H_
@@ -0,0 +1,157 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_EXPR_H_
+#define _MATRIX_OOP_LIB__MATRIX_EXPR_H_
+
+#include <stdexcept>
+#include <type_traits>
+
+// Lazy elementwise expressions. operator+, operator- and scalar operator*
+// build these lightweight nodes instead of Matrix temporaries; the whole tree
+// is evaluated in one fused loop when it is assigned to a Matrix. Nodes hold
+// their children by value and Matrix operands by pointer to their buffer, so
+// an expression must not outlive the matrices it was built from. Elements are
+// addressed by (row, column) through At(), so operands with a row stride
+// other than their width, such as matrix views, take part as well.
+namespace expr {
+
+// A matrix operand: its row-major buffer, shape and row stride.
+template <class T>
+class Leaf {
+ public:
+  using ValueType = T;
+
+  Leaf(const T *data, int rows, int cols, int stride) noexcept
+      : data_(data), rows_(rows), cols_(cols), stride_(stride) {}
+
+  int GetRows() const noexcept { return rows_; }
+  int GetCols() const noexcept { return cols_; }
+  T At(int i, int j) const noexcept { return data_[i * stride_ + j]; }
+
+ private:
+  const T *data_;
+  int rows_, cols_, stride_;
+};
+
+struct Plus {
+  template <class T>
+  static T Apply(const T &a, const T &b) noexcept {
+    return a + b;
+  }
+};
+
+struct Minus {
+  template <class T>
+  static T Apply(const T &a, const T &b) noexcept {
+    return a - b;
+  }
+};
+
+template <class L, class R, class Op>
+class Binary {
+  static_assert(std::is_same<typename L::ValueType,
+                             typename R::ValueType>::value,
+                "Operands of different element types.");
+
+ public:
+  using ValueType = typename L::ValueType;
+
+  Binary(const L &left, const R &right) : left_(left), right_(right) {
+    if (left.GetRows() != right.GetRows() ||
+        left.GetCols() != right.GetCols()) {
+      throw std::invalid_argument("Different matrix dimensions.");
+    }
+  }
+
+  int GetRows() const noexcept { return left_.GetRows(); }
+  int GetCols() const noexcept { return left_.GetCols(); }
+  ValueType At(int i, int j) const noexcept {
+    return Op::Apply(left_.At(i, j), right_.At(i, j));
+  }
+
+ private:
+  L left_;
+  R right_;
+};
+
+template <class E>
+class Scaled {
+ public:
+  using ValueType = typename E::ValueType;
+
+  Scaled(const E &expression, const ValueType &factor) noexcept
+      : expression_(expression), factor_(factor) {}
+
+  int GetRows() const noexcept { return expression_.GetRows(); }
+  int GetCols() const noexcept { return expression_.GetCols(); }
+  ValueType At(int i, int j) const noexcept {
+    return expression_.At(i, j) * factor_;
+  }
+
+ private:
+  E expression_;
+  ValueType factor_;
+};
+
+// True for expression nodes (not for Matrix itself). Matrix views are
+// expressions too, see matrix_view.h.
+template <class T>
+struct IsExpression : std::false_type {};
+template <class L, class R, class Op>
+struct IsExpression<Binary<L, R, Op>> : std::true_type {};
+template <class E>
+struct IsExpression<Scaled<E>> : std::true_type {};
+
+// Maps anything that may appear in an expression to the node stored for it.
+// BasicMatrix specializes this in matrix_oop.h to produce a Leaf.
+template <class T, class = void>
+struct Operand {
+  static const bool kValid = false;
+};
+
+template <class E>
+struct Operand<E, std::enable_if_t<IsExpression<E>::value>> {
+  static const bool kValid = true;
+  using Type = E;
+  static const E &Make(const E &expression) noexcept { return expression; }
+};
+
+template <class L, class R>
+using EnableIfOperands =
+    std::enable_if_t<Operand<L>::kValid && Operand<R>::kValid>;
+
+template <class E>
+using EnableIfOperand = std::enable_if_t<Operand<E>::kValid>;
+
+template <class E>
+using EnableIfExpression = std::enable_if_t<IsExpression<E>::value>;
+
+}  // namespace expr
+
+template <class L, class R, class = expr::EnableIfOperands<L, R>>
+expr::Binary<typename expr::Operand<L>::Type, typename expr::Operand<R>::Type,
+             expr::Plus>
+operator+(const L &left, const R &right) {
+  return {expr::Operand<L>::Make(left), expr::Operand<R>::Make(right)};
+}
+
+template <class L, class R, class = expr::EnableIfOperands<L, R>>
+expr::Binary<typename expr::Operand<L>::Type, typename expr::Operand<R>::Type,
+             expr::Minus>
+operator-(const L &left, const R &right) {
+  return {expr::Operand<L>::Make(left), expr::Operand<R>::Make(right)};
+}
+
+template <class E, class = expr::EnableIfOperand<E>>
+expr::Scaled<typename expr::Operand<E>::Type> operator*(const E &expression,
+                                                        int number) {
+  using T = typename expr::Operand<E>::Type::ValueType;
+  return {expr::Operand<E>::Make(expression), static_cast<T>(number)};
+}
+
+template <class E, class = expr::EnableIfOperand<E>>
+expr::Scaled<typename expr::Operand<E>::Type> operator*(int number,
+                                                        const E &expression) {
+  using T = typename expr::Operand<E>::Type::ValueType;
+  return {expr::Operand<E>::Make(expression), static_cast<T>(number)};
+}
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_EXPR_H_
@@ -0,0 +1,329 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_FIXED_H_
+#define _MATRIX_OOP_LIB__MATRIX_FIXED_H_
+
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+#include "matrix_oop.h"
+
+namespace fixed_detail {
+
+template <class F, std::size_t... I>
+constexpr void Unroll(F &&f, std::index_sequence<I...>) {
+  (f(static_cast<int>(I)), ...);
+}
+
+// Calls f(0), f(1), ..., f(N - 1) as a flat sequence of calls, so loops over
+// compile-time extents are unrolled regardless of optimizer heuristics.
+template <std::size_t N, class F>
+constexpr void Unroll(F &&f) {
+  Unroll(f, std::make_index_sequence<N>());
+}
+
+constexpr double Abs(double value) noexcept {
+  return value < 0 ? -value : value;
+}
+
+}  // namespace fixed_detail
+
+// Matrix with compile-time shape and inline storage. Every operation is
+// constexpr and free of heap allocation. Elementwise operations, products
+// and transposes are unrolled over the extents, and the determinant and
+// inverse are closed forms up to 4x4; larger ones fall back to pivoting
+// loops. Conversions to and from the dynamic Matrix are explicit.
+template <int R, int C>
+class FixedMatrix {
+  static_assert(R > 0 && C > 0, "FixedMatrix extents must be positive.");
+
+ public:
+  constexpr FixedMatrix() noexcept : data_{} {}
+  // Row-major element values; missing trailing elements are zero.
+  constexpr FixedMatrix(std::initializer_list<double> values) : data_{} {
+    if (values.size() > static_cast<std::size_t>(R * C)) {
+      throw std::invalid_argument("Too many matrix elements.");
+    }
+    int k = 0;
+    for (double value : values) data_[k++] = value;
+  }
+  explicit FixedMatrix(const Matrix &matrix) : data_{} {
+    if (matrix.GetRows() != R || matrix.GetCols() != C) {
+      throw std::invalid_argument("Different matrix dimensions.");
+    }
+    const double *src = matrix.Data();
+    fixed_detail::Unroll<R * C>([&](int k) { data_[k] = src[k]; });
+  }
+
+  explicit operator Matrix() const {
+    Matrix result(R, C);
+    double *dst = result.Data();
+    fixed_detail::Unroll<R * C>([&](int k) { dst[k] = data_[k]; });
+    return result;
+  }
+
+  static constexpr int GetRows() noexcept { return R; }
+  static constexpr int GetCols() noexcept { return C; }
+
+  constexpr double &operator()(int i, int j) {
+    if (i < 0 || i >= R || j < 0 || j >= C) {
+      throw std::out_of_range("Index out of range.");
+    }
+    return data_[i * C + j];
+  }
+  constexpr const double &operator()(int i, int j) const {
+    if (i < 0 || i >= R || j < 0 || j >= C) {
+      throw std::out_of_range("Index out of range.");
+    }
+    return data_[i * C + j];
+  }
+
+  constexpr bool operator==(const FixedMatrix &other) const noexcept {
+    bool output = true;
+    fixed_detail::Unroll<R * C>([&](int k) {
+      if (fixed_detail::Abs(data_[k] - other.data_[k]) > kEpsilon) {
+        output = false;
+      }
+    });
+    return output;
+  }
+  constexpr bool operator!=(const FixedMatrix &other) const noexcept {
+    return !(*this == other);
+  }
+
+  constexpr FixedMatrix &operator+=(const FixedMatrix &other) noexcept {
+    fixed_detail::Unroll<R * C>([&](int k) { data_[k] += other.data_[k]; });
+    return *this;
+  }
+  constexpr FixedMatrix &operator-=(const FixedMatrix &other) noexcept {
+    fixed_detail::Unroll<R * C>([&](int k) { data_[k] -= other.data_[k]; });
+    return *this;
+  }
+  constexpr FixedMatrix &operator*=(double number) noexcept {
+    fixed_detail::Unroll<R * C>([&](int k) { data_[k] *= number; });
+    return *this;
+  }
+
+  constexpr FixedMatrix operator+(const FixedMatrix &other) const noexcept {
+    FixedMatrix result = *this;
+    result += other;
+    return result;
+  }
+  constexpr FixedMatrix operator-(const FixedMatrix &other) const noexcept {
+    FixedMatrix result = *this;
+    result -= other;
+    return result;
+  }
+  constexpr FixedMatrix operator*(double number) const noexcept {
+    FixedMatrix result = *this;
+    result *= number;
+    return result;
+  }
+  friend constexpr FixedMatrix operator*(double number,
+                                         const FixedMatrix &matrix) noexcept {
+    return matrix * number;
+  }
+
+  template <int K>
+  constexpr FixedMatrix<R, K> operator*(
+      const FixedMatrix<C, K> &other) const noexcept {
+    FixedMatrix<R, K> result;
+    fixed_detail::Unroll<R>([&](int i) {
+      fixed_detail::Unroll<K>([&](int j) {
+        double sum = 0;
+        fixed_detail::Unroll<C>(
+            [&](int k) { sum += data_[i * C + k] * other.data_[k * K + j]; });
+        result.data_[i * K + j] = sum;
+      });
+    });
+    return result;
+  }
+
+  constexpr FixedMatrix<C, R> Transpose() const noexcept {
+    FixedMatrix<C, R> result;
+    fixed_detail::Unroll<R>([&](int i) {
+      fixed_detail::Unroll<C>(
+          [&](int j) { result.data_[j * R + i] = data_[i * C + j]; });
+    });
+    return result;
+  }
+
+  // Closed form up to 4x4, Gaussian elimination with partial pivoting above.
+  constexpr double Determinant() const noexcept {
+    static_assert(R == C, "The matrix is not square.");
+    const double *a = data_;
+    double result = 0;
+    if constexpr (R == 1) {
+      result = a[0];
+    } else if constexpr (R == 2) {
+      result = a[0] * a[3] - a[1] * a[2];
+    } else if constexpr (R == 3) {
+      result = a[0] * (a[4] * a[8] - a[5] * a[7]) -
+               a[1] * (a[3] * a[8] - a[5] * a[6]) +
+               a[2] * (a[3] * a[7] - a[4] * a[6]);
+    } else if constexpr (R == 4) {
+      double s[6] = {};
+      double c[6] = {};
+      Minors4(s, c);
+      result = Determinant4(s, c);
+    } else {
+      FixedMatrix lu = *this;
+      result = 1;
+      for (int k = 0; k < R && result != 0; ++k) {
+        int pivot_row = lu.PivotRow(k);
+        if (pivot_row != k) {
+          lu.SwapRows(k, pivot_row);
+          result = -result;
+        }
+        const double pivot = lu.data_[k * C + k];
+        result *= pivot;
+        if (pivot == 0) break;
+        for (int i = k + 1; i < R; ++i) {
+          const double l_ik = lu.data_[i * C + k] / pivot;
+          for (int j = k + 1; j < C; ++j) {
+            lu.data_[i * C + j] -= l_ik * lu.data_[k * C + j];
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  // Closed-form adjugate up to 4x4, Gauss-Jordan with partial pivoting above.
+  // Throws when the matrix is singular.
+  constexpr FixedMatrix InverseMatrix() const {
+    static_assert(R == C, "The matrix is not square.");
+    FixedMatrix result;
+    const double *a = data_;
+    double *x = result.data_;
+    if constexpr (R <= 4) {
+      double s[6] = {};
+      double c[6] = {};
+      double determinant = 0;
+      if constexpr (R == 4) {
+        Minors4(s, c);
+        determinant = Determinant4(s, c);
+      } else {
+        determinant = Determinant();
+      }
+      if (fixed_detail::Abs(determinant) < kEpsilon) {
+        throw std::invalid_argument("The matrix determinant is 0.");
+      }
+      if constexpr (R == 1) {
+        x[0] = 1;
+      } else if constexpr (R == 2) {
+        x[0] = a[3];
+        x[1] = -a[1];
+        x[2] = -a[2];
+        x[3] = a[0];
+      } else if constexpr (R == 3) {
+        x[0] = a[4] * a[8] - a[5] * a[7];
+        x[1] = a[2] * a[7] - a[1] * a[8];
+        x[2] = a[1] * a[5] - a[2] * a[4];
+        x[3] = a[5] * a[6] - a[3] * a[8];
+        x[4] = a[0] * a[8] - a[2] * a[6];
+        x[5] = a[2] * a[3] - a[0] * a[5];
+        x[6] = a[3] * a[7] - a[4] * a[6];
+        x[7] = a[1] * a[6] - a[0] * a[7];
+        x[8] = a[0] * a[4] - a[1] * a[3];
+      } else {
+        x[0] = a[5] * c[5] - a[6] * c[4] + a[7] * c[3];
+        x[1] = -a[1] * c[5] + a[2] * c[4] - a[3] * c[3];
+        x[2] = a[13] * s[5] - a[14] * s[4] + a[15] * s[3];
+        x[3] = -a[9] * s[5] + a[10] * s[4] - a[11] * s[3];
+        x[4] = -a[4] * c[5] + a[6] * c[2] - a[7] * c[1];
+        x[5] = a[0] * c[5] - a[2] * c[2] + a[3] * c[1];
+        x[6] = -a[12] * s[5] + a[14] * s[2] - a[15] * s[1];
+        x[7] = a[8] * s[5] - a[10] * s[2] + a[11] * s[1];
+        x[8] = a[4] * c[4] - a[5] * c[2] + a[7] * c[0];
+        x[9] = -a[0] * c[4] + a[1] * c[2] - a[3] * c[0];
+        x[10] = a[12] * s[4] - a[13] * s[2] + a[15] * s[0];
+        x[11] = -a[8] * s[4] + a[9] * s[2] - a[11] * s[0];
+        x[12] = -a[4] * c[3] + a[5] * c[1] - a[6] * c[0];
+        x[13] = a[0] * c[3] - a[1] * c[1] + a[2] * c[0];
+        x[14] = -a[12] * s[3] + a[13] * s[1] - a[14] * s[0];
+        x[15] = a[8] * s[3] - a[9] * s[1] + a[10] * s[0];
+      }
+      result *= 1 / determinant;
+    } else {
+      FixedMatrix work = *this;
+      fixed_detail::Unroll<R>([&](int i) { x[i * C + i] = 1; });
+      for (int k = 0; k < R; ++k) {
+        int pivot_row = work.PivotRow(k);
+        if (fixed_detail::Abs(work.data_[pivot_row * C + k]) < kEpsilon) {
+          throw std::invalid_argument("The matrix determinant is 0.");
+        }
+        work.SwapRows(k, pivot_row);
+        result.SwapRows(k, pivot_row);
+        const double inverse_pivot = 1 / work.data_[k * C + k];
+        for (int j = 0; j < C; ++j) {
+          work.data_[k * C + j] *= inverse_pivot;
+          x[k * C + j] *= inverse_pivot;
+        }
+        for (int i = 0; i < R; ++i) {
+          const double factor = work.data_[i * C + k];
+          if (i == k || factor == 0) continue;
+          for (int j = 0; j < C; ++j) {
+            work.data_[i * C + j] -= factor * work.data_[k * C + j];
+            x[i * C + j] -= factor * x[k * C + j];
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+ private:
+  template <int, int>
+  friend class FixedMatrix;
+
+  double data_[R * C];
+
+  // 2x2 minors of a 4x4 matrix: s from rows 0 and 1, c from rows 2 and 3,
+  // both over the column pairs (0, 1), (0, 2), (0, 3), (1, 2), (1, 3),
+  // (2, 3), with c in reverse order. The determinant and the adjugate are
+  // sums of their products.
+  constexpr void Minors4(double *s, double *c) const noexcept {
+    const double *a = data_;
+    s[0] = a[0] * a[5] - a[4] * a[1];
+    s[1] = a[0] * a[6] - a[4] * a[2];
+    s[2] = a[0] * a[7] - a[4] * a[3];
+    s[3] = a[1] * a[6] - a[5] * a[2];
+    s[4] = a[1] * a[7] - a[5] * a[3];
+    s[5] = a[2] * a[7] - a[6] * a[3];
+    c[5] = a[10] * a[15] - a[14] * a[11];
+    c[4] = a[9] * a[15] - a[13] * a[11];
+    c[3] = a[9] * a[14] - a[13] * a[10];
+    c[2] = a[8] * a[15] - a[12] * a[11];
+    c[1] = a[8] * a[14] - a[12] * a[10];
+    c[0] = a[8] * a[13] - a[12] * a[9];
+  }
+
+  static constexpr double Determinant4(const double *s,
+                                       const double *c) noexcept {
+    return s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] -
+           s[4] * c[1] + s[5] * c[0];
+  }
+
+  constexpr int PivotRow(int k) const noexcept {
+    int pivot_row = k;
+    for (int i = k + 1; i < R; ++i) {
+      if (fixed_detail::Abs(data_[i * C + k]) >
+          fixed_detail::Abs(data_[pivot_row * C + k])) {
+        pivot_row = i;
+      }
+    }
+    return pivot_row;
+  }
+
+  constexpr void SwapRows(int first, int second) noexcept {
+    if (first == second) return;
+    for (int j = 0; j < C; ++j) {
+      double tmp = data_[first * C + j];
+      data_[first * C + j] = data_[second * C + j];
+      data_[second * C + j] = tmp;
+    }
+  }
+};
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_FIXED_H_
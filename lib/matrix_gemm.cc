@@ -0,0 +1,401 @@
+#include "matrix_gemm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "matrix_memory.h"
+#include "matrix_threads.h"
+
+namespace gemm {
+
+namespace {
+
+// Below this many multiply-adds packing costs more than it saves.
+const long kSmallProduct = 32L * 32L * 32L;
+// Below this many multiply-adds the product stays on the calling thread.
+const long kParallelProduct = 96L * 96L * 96L;
+
+// Operands are addressed through a row stride rs and a column stride cs, so
+// element (i, j) is at x[i * rs + j * cs]. A transposed row-major operand
+// just swaps the two strides.
+
+// Copies an mc x kc block of A into kMr-row micro-panels, each stored
+// column after column so the micro-kernel reads it sequentially. Rows past
+// mc are zero padded.
+template <class T>
+void PackA(int mc, int kc, const T* a, int rs, int cs, T* packed) {
+  for (int i = 0; i < mc; i += kMr) {
+    const int mr = std::min(kMr, mc - i);
+    for (int p = 0; p < kc; ++p) {
+      for (int r = 0; r < mr; ++r) {
+        packed[r] = a[(i + r) * rs + p * cs];
+      }
+      for (int r = mr; r < kMr; ++r) {
+        packed[r] = 0;
+      }
+      packed += kMr;
+    }
+  }
+}
+
+// Copies a kc x nc block of B into kNr-column micro-panels, each stored row
+// after row. Columns past nc are zero padded.
+template <class T>
+void PackB(int kc, int nc, const T* b, int rs, int cs, T* packed) {
+  for (int j = 0; j < nc; j += kNr) {
+    const int nr = std::min(kNr, nc - j);
+    for (int p = 0; p < kc; ++p) {
+      const T* row = b + p * rs + j * cs;
+      for (int r = 0; r < nr; ++r) {
+        packed[r] = row[r * cs];
+      }
+      for (int r = nr; r < kNr; ++r) {
+        packed[r] = 0;
+      }
+      packed += kNr;
+    }
+  }
+}
+
+// Packing buffer of the calling thread. It grows to the largest block
+// packed so far, which the blocking parameters bound, and is only
+// default-initialized since every block is packed before it is read. Storage
+// comes from std::pmr::get_default_resource() at the time of growth and goes
+// back to that resource, which therefore has to outlive the thread.
+template <class T>
+class PackBuffer {
+ public:
+  PackBuffer() : resource_(nullptr), data_(nullptr), size_(0) {}
+  ~PackBuffer() { Free(); }
+
+  PackBuffer(const PackBuffer&) = delete;
+  PackBuffer& operator=(const PackBuffer&) = delete;
+
+  T* Get(size_t size) {
+    if (size_ < size) {
+      Free();
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+      data_ = static_cast<T*>(
+          resource->allocate(size * sizeof(T), alignof(T)));
+      std::uninitialized_default_construct_n(data_, size);
+      resource_ = resource;
+      size_ = size;
+    }
+    return data_;
+  }
+
+ private:
+  std::pmr::memory_resource* resource_;
+  T* data_;
+  size_t size_;
+
+  void Free() noexcept {
+    if (data_ != nullptr) {
+      resource_->deallocate(data_, size_ * sizeof(T), alignof(T));
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+};
+
+// C[mr x nr] += packed A micro-panel * packed B micro-panel. The full
+// kMr x kNr tile is accumulated in registers; only the valid part is stored.
+template <class T>
+void MicroKernel(int kc, T alpha, const T* a, const T* b, T* c, int ldc,
+                 int mr, int nr) {
+  T acc[kMr][kNr] = {};
+  for (int p = 0; p < kc; ++p) {
+    for (int i = 0; i < kMr; ++i) {
+      const T a_ip = a[i];
+      for (int j = 0; j < kNr; ++j) {
+        acc[i][j] += a_ip * b[j];
+      }
+    }
+    a += kMr;
+    b += kNr;
+  }
+  for (int i = 0; i < mr; ++i) {
+    T* row = c + i * ldc;
+    for (int j = 0; j < nr; ++j) {
+      row[j] += alpha * acc[i][j];
+    }
+  }
+}
+
+template <class T>
+void MultiplySmall(int m, int n, int k, T alpha, const T* a, int a_rs,
+                   int a_cs, const T* b, int b_rs, int b_cs, T* c, int ldc) {
+  for (int i = 0; i < m; ++i) {
+    T* c_row = c + i * ldc;
+    for (int p = 0; p < k; ++p) {
+      const T a_ip = alpha * a[i * a_rs + p * a_cs];
+      const T* b_row = b + p * b_rs;
+      if (b_cs == 1) {
+        for (int j = 0; j < n; ++j) {
+          c_row[j] += a_ip * b_row[j];
+        }
+      } else {
+        for (int j = 0; j < n; ++j) {
+          c_row[j] += a_ip * b_row[j * b_cs];
+        }
+      }
+    }
+  }
+}
+
+std::atomic<Algorithm> algorithm(Algorithm::kClassical);
+std::atomic<int> strassen_crossover(kDefaultStrassenCrossover);
+
+// z = x + y and z = x - y for rows x cols blocks; z may be x or y.
+template <class T>
+void AddBlocks(int rows, int cols, const T* x, int ldx, const T* y, int ldy,
+               T* z, int ldz) {
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      z[i * ldz + j] = x[i * ldx + j] + y[i * ldy + j];
+    }
+  }
+}
+
+template <class T>
+void SubBlocks(int rows, int cols, const T* x, int ldx, const T* y, int ldy,
+               T* z, int ldz) {
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      z[i * ldz + j] = x[i * ldx + j] - y[i * ldy + j];
+    }
+  }
+}
+
+template <class T>
+void ZeroBlock(int rows, int cols, T* z, int ldz) {
+  for (int i = 0; i < rows; ++i) {
+    std::fill(z + i * ldz, z + i * ldz + cols, T());
+  }
+}
+
+bool UseStrassen(int m, int n, int k, int crossover) noexcept {
+  return m >= crossover && n >= crossover && k >= crossover;
+}
+
+// Elements of workspace Winograd needs below a product of this shape.
+size_t WinogradWorkspace(int m, int n, int k, int crossover) {
+  size_t output = 0;
+  while (UseStrassen(m, n, k, crossover)) {
+    m /= 2;
+    n /= 2;
+    k /= 2;
+    output += static_cast<size_t>(m) * std::max(k, n) +
+              static_cast<size_t>(k) * n;
+  }
+  return output;
+}
+
+// C = A * B by Strassen-Winograd recursion, overwriting C. Each level uses
+// two temporaries from `work`, X for sums of A blocks and for P1 and Y for
+// sums of B blocks, in the schedule of Boyer, Dumas, Pernet and Zhou; the
+// remaining workspace serves the level below. Odd dimensions are peeled off
+// and handled by the classical kernel.
+template <class T>
+void Winograd(int m, int n, int k, const T* a, int lda, const T* b, int ldb,
+              T* c, int ldc, T* work, int crossover) {
+  if (!UseStrassen(m, n, k, crossover)) {
+    ZeroBlock(m, n, c, ldc);
+    Multiply(m, n, k, T(1), a, lda, b, ldb, c, ldc);
+    return;
+  }
+  const int mh = m / 2, nh = n / 2, kh = k / 2;
+  const T* a11 = a;
+  const T* a12 = a + kh;
+  const T* a21 = a + mh * lda;
+  const T* a22 = a21 + kh;
+  const T* b11 = b;
+  const T* b12 = b + nh;
+  const T* b21 = b + kh * ldb;
+  const T* b22 = b21 + nh;
+  T* c11 = c;
+  T* c12 = c + nh;
+  T* c21 = c + mh * ldc;
+  T* c22 = c21 + nh;
+  const int ldx = std::max(kh, nh);
+  T* x = work;
+  T* y = x + static_cast<size_t>(mh) * ldx;
+  T* next = y + static_cast<size_t>(kh) * nh;
+  auto product = [&](const T* left, int ld_left, const T* right,
+                     int ld_right, T* out, int ld_out) {
+    Winograd(mh, nh, kh, left, ld_left, right, ld_right, out, ld_out, next,
+             crossover);
+  };
+
+  SubBlocks(mh, kh, a11, lda, a21, lda, x, ldx);  // S3
+  SubBlocks(kh, nh, b22, ldb, b12, ldb, y, nh);   // T3
+  product(x, ldx, y, nh, c21, ldc);               // P7
+  AddBlocks(mh, kh, a21, lda, a22, lda, x, ldx);  // S1
+  SubBlocks(kh, nh, b12, ldb, b11, ldb, y, nh);   // T1
+  product(x, ldx, y, nh, c22, ldc);               // P5
+  SubBlocks(mh, kh, x, ldx, a11, lda, x, ldx);    // S2
+  SubBlocks(kh, nh, b22, ldb, y, nh, y, nh);      // T2
+  product(x, ldx, y, nh, c12, ldc);               // P6
+  SubBlocks(mh, kh, a12, lda, x, ldx, x, ldx);    // S4
+  product(x, ldx, b22, ldb, c11, ldc);            // P3
+  product(a11, lda, b11, ldb, x, ldx);            // P1
+  AddBlocks(mh, nh, x, ldx, c12, ldc, c12, ldc);  // U2 = P1 + P6
+  AddBlocks(mh, nh, c12, ldc, c21, ldc, c21, ldc);  // U3 = U2 + P7
+  AddBlocks(mh, nh, c12, ldc, c22, ldc, c12, ldc);  // U4 = U2 + P5
+  AddBlocks(mh, nh, c21, ldc, c22, ldc, c22, ldc);  // U7 = U3 + P5, C22
+  AddBlocks(mh, nh, c12, ldc, c11, ldc, c12, ldc);  // U5 = U4 + P3, C12
+  SubBlocks(kh, nh, y, nh, b21, ldb, y, nh);        // T4
+  product(a22, lda, y, nh, c11, ldc);               // P4
+  SubBlocks(mh, nh, c21, ldc, c11, ldc, c21, ldc);  // U6 = U3 - P4, C21
+  product(a12, lda, b21, ldb, c11, ldc);            // P2
+  AddBlocks(mh, nh, x, ldx, c11, ldc, c11, ldc);    // U1 = P1 + P2, C11
+
+  const int me = 2 * mh, ne = 2 * nh, ke = 2 * kh;
+  if (ke < k) {
+    Multiply(me, ne, 1, T(1), a + ke, lda, b + ke * ldb, ldb, c, ldc);
+  }
+  if (ne < n) {
+    ZeroBlock(m, 1, c + ne, ldc);
+    Multiply(m, 1, k, T(1), a, lda, b + ne, ldb, c + ne, ldc);
+  }
+  if (me < m) {
+    ZeroBlock(1, ne, c + me * ldc, ldc);
+    Multiply(1, ne, k, T(1), a + me * lda, lda, b, ldb, c + me * ldc, ldc);
+  }
+}
+
+// C += alpha * A * B through Winograd. The product and the temporaries
+// share one buffer taken from memory::GetResource() for the call, so a scoped
+// pool serves repeated products and nothing stays allocated afterwards. At
+// the default crossover the allocation is noise against the O(n^2.81) work.
+template <class T>
+void MultiplyStrassen(int m, int n, int k, T alpha, const T* a, int lda,
+                      const T* b, int ldb, T* c, int ldc, int crossover) {
+  const size_t product = static_cast<size_t>(m) * n;
+  std::pmr::vector<T> workspace(
+      product + WinogradWorkspace(m, n, k, crossover), memory::GetResource());
+  T* result = workspace.data();
+  Winograd(m, n, k, a, lda, b, ldb, result, n, result + product, crossover);
+  for (int i = 0; i < m; ++i) {
+    T* c_row = c + i * ldc;
+    const T* row = result + static_cast<size_t>(i) * n;
+    for (int j = 0; j < n; ++j) {
+      c_row[j] += alpha * row[j];
+    }
+  }
+}
+
+}  // namespace
+
+Algorithm GetAlgorithm() noexcept { return algorithm.load(); }
+
+void SetAlgorithm(Algorithm value) noexcept { algorithm.store(value); }
+
+int GetStrassenCrossover() noexcept { return strassen_crossover.load(); }
+
+void SetStrassenCrossover(int size) noexcept {
+  strassen_crossover.store(std::max(size, kMinStrassenCrossover));
+}
+
+template <class T>
+void Multiply(int m, int n, int k, T alpha, const T* a, int lda, const T* b,
+              int ldb, T* c, int ldc) {
+  Multiply(Op::kNoTrans, Op::kNoTrans, m, n, k, alpha, a, lda, b, ldb, c,
+           ldc);
+}
+
+template <class T>
+void Multiply(Op op_a, Op op_b, int m, int n, int k, T alpha, const T* a,
+              int lda, const T* b, int ldb, T* c, int ldc) {
+  if (m == 0 || n == 0 || k == 0 || alpha == T(0)) return;
+  const int crossover = strassen_crossover.load();
+  if (algorithm.load() == Algorithm::kStrassen && op_a == Op::kNoTrans &&
+      op_b == Op::kNoTrans && UseStrassen(m, n, k, crossover)) {
+    MultiplyStrassen(m, n, k, alpha, a, lda, b, ldb, c, ldc, crossover);
+    return;
+  }
+  const int a_rs = (op_a == Op::kNoTrans) ? lda : 1;
+  const int a_cs = (op_a == Op::kNoTrans) ? 1 : lda;
+  const int b_rs = (op_b == Op::kNoTrans) ? ldb : 1;
+  const int b_cs = (op_b == Op::kNoTrans) ? 1 : ldb;
+  const long product = static_cast<long>(m) * n * k;
+  if (product <= kSmallProduct) {
+    MultiplySmall(m, n, k, alpha, a, a_rs, a_cs, b, b_rs, b_cs, c, ldc);
+    return;
+  }
+  // Row blocks of C are shared out between threads; shrink them when m is
+  // too small to give every thread at least one full kMc block. Nested in
+  // another parallel region the product runs on one thread and keeps them.
+  int mc_step = kMc;
+  const int num_threads =
+      (product < kParallelProduct) ? 1 : threads::GetConcurrency();
+  if (num_threads > 1 && m < kMc * num_threads) {
+    const int rows = (m + num_threads - 1) / num_threads;
+    mc_step = std::max(kMr, (rows + kMr - 1) / kMr * kMr);
+  }
+  const int row_blocks = (m + mc_step - 1) / mc_step;
+  thread_local PackBuffer<T> packed_b_buffer;
+  const int nc_max = std::min(kNc, n);
+  T* packed_b = packed_b_buffer.Get(static_cast<size_t>(std::min(kKc, k)) *
+                                    ((nc_max + kNr - 1) / kNr * kNr));
+  for (int jc = 0; jc < n; jc += kNc) {
+    const int nc = std::min(kNc, n - jc);
+    for (int pc = 0; pc < k; pc += kKc) {
+      const int kc = std::min(kKc, k - pc);
+      PackB(kc, nc, b + pc * b_rs + jc * b_cs, b_rs, b_cs, packed_b);
+      auto row_range = [&](int begin, int end) {
+        thread_local PackBuffer<T> packed_a_buffer;
+        T* packed_a = packed_a_buffer.Get(
+            static_cast<size_t>((std::min(mc_step, m) + kMr - 1) / kMr * kMr) *
+            kc);
+        for (int block = begin; block < end; ++block) {
+          const int ic = block * mc_step;
+          const int mc = std::min(mc_step, m - ic);
+          PackA(mc, kc, a + ic * a_rs + pc * a_cs, a_rs, a_cs, packed_a);
+          for (int jr = 0; jr < nc; jr += kNr) {
+            const int nr = std::min(kNr, nc - jr);
+            for (int ir = 0; ir < mc; ir += kMr) {
+              const int mr = std::min(kMr, mc - ir);
+              MicroKernel(kc, alpha, packed_a + ir * kc, packed_b + jr * kc,
+                          c + (ic + ir) * ldc + jc + jr, ldc, mr, nr);
+            }
+          }
+        }
+      };
+      if (num_threads > 1) {
+        // By reference, so the std::function does not copy the lambda to
+        // the heap.
+        threads::ParallelFor(row_blocks, 1, std::ref(row_range));
+      } else {
+        row_range(0, row_blocks);
+      }
+    }
+  }
+}
+
+template void Multiply<float>(Op, Op, int, int, int, float, const float*, int,
+                              const float*, int, float*, int);
+template void Multiply<double>(Op, Op, int, int, int, double, const double*,
+                               int, const double*, int, double*, int);
+template void Multiply<std::complex<double>>(Op, Op, int, int, int,
+                                             std::complex<double>,
+                                             const std::complex<double>*, int,
+                                             const std::complex<double>*, int,
+                                             std::complex<double>*, int);
+template void Multiply<float>(int, int, int, float, const float*, int,
+                              const float*, int, float*, int);
+template void Multiply<double>(int, int, int, double, const double*, int,
+                               const double*, int, double*, int);
+template void Multiply<std::complex<double>>(int, int, int,
+                                             std::complex<double>,
+                                             const std::complex<double>*, int,
+                                             const std::complex<double>*, int,
+                                             std::complex<double>*, int);
+
+}  // namespace gemm
@@ -0,0 +1,53 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_GEMM_H_
+#define _MATRIX_OOP_LIB__MATRIX_GEMM_H_
+
+namespace gemm {
+
+// Blocking parameters of the packed kernel. kMr x kNr is the register tile of
+// the micro-kernel, kKc x kNr panels of B are sized to stay in L1, a
+// kMc x kKc block of A in L2 and a kKc x kNc block of B in L3.
+const int kMr = 4;
+const int kNr = 8;
+const int kMc = 128;
+const int kKc = 256;
+const int kNc = 2048;
+
+// Whether an operand enters the product as stored or transposed.
+enum class Op { kNoTrans, kTrans };
+
+// Accuracy policy for large products. kClassical, the default, always runs
+// the O(n^3) kernel. kStrassen lets products whose three dimensions all reach
+// the crossover size go through Strassen-Winograd recursion, which performs
+// 7 instead of 8 half-size products per level at the price of a normwise
+// rather than elementwise error bound that grows with the recursion depth.
+enum class Algorithm { kClassical, kStrassen };
+
+Algorithm GetAlgorithm() noexcept;
+void SetAlgorithm(Algorithm algorithm) noexcept;
+// Dimension below which the recursion hands over to the classical kernel.
+int GetStrassenCrossover() noexcept;
+// Sets the crossover, clamped to at least kMinStrassenCrossover.
+void SetStrassenCrossover(int size) noexcept;
+
+const int kDefaultStrassenCrossover = 1024;
+const int kMinStrassenCrossover = 16;
+
+// C[m x n] += alpha * A[m x k] * B[k x n] for row-major operands with
+// leading dimensions lda, ldb and ldc. Large products are split by row blocks
+// of C across the library thread pool. Instantiated for float, double and
+// std::complex<double>.
+template <class T>
+void Multiply(int m, int n, int k, T alpha, const T *a, int lda, const T *b,
+              int ldb, T *c, int ldc);
+
+// C[m x n] += alpha * op(A)[m x k] * op(B)[k x n], where op_a and op_b say
+// whether A (stored m x k, or k x m when transposed) and B are transposed.
+// Transposition happens while packing, so it costs no extra pass or buffer.
+// Follows GetAlgorithm() for untransposed operands.
+template <class T>
+void Multiply(Op op_a, Op op_b, int m, int n, int k, T alpha, const T *a,
+              int lda, const T *b, int ldb, T *c, int ldc);
+
+}  // namespace gemm
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_GEMM_H_
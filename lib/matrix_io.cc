@@ -0,0 +1,683 @@
+#include "matrix_io.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <charconv>
+#include <complex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace io {
+
+namespace {
+
+const char kMagic[8] = "MATRIXB";
+const std::uint32_t kVersion = 1;
+const std::uint32_t kByteOrderMark = 0x01020304;
+const std::uint32_t kRowMajor = 0;
+// Largest single read or write, well below the limits of the system calls.
+const std::size_t kChunk = std::size_t(1) << 24;
+
+// Blocks the text reader and writer move through the stream.
+const std::size_t kTextChunk = std::size_t(1) << 20;
+// Room for one number in the shortest round-trip form and a separator.
+const std::size_t kMaxNumberText = 32;
+
+struct Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint32_t element_type;
+  std::uint32_t layout;
+  std::uint32_t alignment;
+  std::uint32_t reserved;
+  std::int64_t rows;
+  std::int64_t cols;
+  std::uint64_t offset;
+  char padding[8];
+};
+
+static_assert(sizeof(Header) == kFileAlignment, "Header is not 64 bytes.");
+
+template <class T>
+struct ElementType;
+template <>
+struct ElementType<float> {
+  static const std::uint32_t kValue = 1;
+};
+template <>
+struct ElementType<double> {
+  static const std::uint32_t kValue = 2;
+};
+template <>
+struct ElementType<std::complex<double>> {
+  static const std::uint32_t kValue = 3;
+};
+
+[[noreturn]] void ThrowSystemError(const char* what, const std::string& path) {
+  throw std::system_error(errno, std::generic_category(),
+                          std::string(what) + " " + path);
+}
+
+// Owns a file descriptor.
+class File {
+ public:
+  File(const std::string& path, int flags)
+      : path_(path), fd_(::open(path.c_str(), flags | O_CLOEXEC, 0644)) {
+    if (fd_ < 0) ThrowSystemError("Cannot open", path_);
+  }
+  ~File() {
+    if (fd_ >= 0) ::close(fd_);
+  }
+
+  File(const File&) = delete;
+  File& operator=(const File&) = delete;
+
+  std::size_t Size() const { return static_cast<std::size_t>(Stat().st_size); }
+
+  // Whether both descriptors refer to the same file, whatever the paths.
+  bool SameFile(const File& other) const {
+    const struct stat mine = Stat();
+    const struct stat theirs = other.Stat();
+    return mine.st_dev == theirs.st_dev && mine.st_ino == theirs.st_ino;
+  }
+
+  void Write(const void* data, std::size_t bytes, std::size_t offset) const {
+    const char* next = static_cast<const char*>(data);
+    while (bytes > 0) {
+      const ssize_t written = ::pwrite(fd_, next, std::min(bytes, kChunk),
+                                       static_cast<off_t>(offset));
+      if (written < 0 && errno == EINTR) continue;
+      if (written <= 0) ThrowSystemError("Cannot write", path_);
+      next += written;
+      offset += static_cast<std::size_t>(written);
+      bytes -= static_cast<std::size_t>(written);
+    }
+  }
+
+  void Read(void* data, std::size_t bytes, std::size_t offset) const {
+    char* next = static_cast<char*>(data);
+    while (bytes > 0) {
+      const ssize_t got = ::pread(fd_, next, std::min(bytes, kChunk),
+                                  static_cast<off_t>(offset));
+      if (got < 0 && errno == EINTR) continue;
+      if (got < 0) ThrowSystemError("Cannot read", path_);
+      if (got == 0) throw std::invalid_argument("Invalid matrix file.");
+      next += got;
+      offset += static_cast<std::size_t>(got);
+      bytes -= static_cast<std::size_t>(got);
+    }
+  }
+
+  // Sets the file length; an extension reads back as zeros.
+  void Resize(std::size_t size) const {
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      ThrowSystemError("Cannot resize", path_);
+    }
+  }
+
+  int Descriptor() const noexcept { return fd_; }
+
+ private:
+  std::string path_;
+  int fd_;
+
+  struct stat Stat() const {
+    struct stat info;
+    if (::fstat(fd_, &info) != 0) ThrowSystemError("Cannot stat", path_);
+    return info;
+  }
+};
+
+// A background thread that runs load(step) for one step at a time, so that
+// the reads of the next step overlap the work on the current one without a
+// thread per step. An exception from load is rethrown by Wait().
+class Prefetcher {
+ public:
+  explicit Prefetcher(std::function<void(int)> load)
+      : load_(std::move(load)),
+        mutex_(),
+        wake_(),
+        done_(),
+        step_(0),
+        busy_(false),
+        stop_(false),
+        error_(),
+        thread_(&Prefetcher::Loop, this) {}
+  ~Prefetcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+  }
+
+  Prefetcher(const Prefetcher&) = delete;
+  Prefetcher& operator=(const Prefetcher&) = delete;
+
+  // Starts loading step; the previous one must have been waited for.
+  void Start(int step) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      step_ = step;
+      busy_ = true;
+    }
+    wake_.notify_one();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return !busy_; });
+    if (error_) {
+      std::exception_ptr error = error_;
+      error_ = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+ private:
+  std::function<void(int)> load_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  int step_;
+  bool busy_;
+  bool stop_;
+  std::exception_ptr error_;
+  std::thread thread_;
+
+  void Loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [this] { return stop_ || busy_; });
+      if (stop_) break;
+      const int step = step_;
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        load_(step);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      error_ = error;
+      busy_ = false;
+      done_.notify_one();
+    }
+  }
+};
+
+// Whether a rows x cols matrix has few enough elements for the int sizes
+// and offsets of BasicMatrix and BasicMatrixView. The product is taken in 64
+// bits, where two int dimensions cannot overflow it.
+bool Addressable(std::int64_t rows, std::int64_t cols) noexcept {
+  const std::int64_t kMaxElements = std::numeric_limits<int>::max();
+  return rows >= 0 && cols >= 0 && rows <= kMaxElements &&
+         cols <= kMaxElements && rows * cols <= kMaxElements;
+}
+
+// Checks header against a file of file_size bytes holding T elements, which
+// must end right after the elements, and returns the number of bytes of
+// element data.
+template <class T>
+std::size_t CheckHeader(const Header& header, std::size_t file_size) {
+  if (file_size < sizeof(Header) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.byte_order != kByteOrderMark ||
+      header.layout != kRowMajor || !Addressable(header.rows, header.cols) ||
+      header.offset < sizeof(Header) || header.offset % alignof(T) != 0) {
+    throw std::invalid_argument("Invalid matrix file.");
+  }
+  if (header.element_type != ElementType<T>::kValue) {
+    throw std::invalid_argument("Different element types.");
+  }
+  const std::uint64_t bytes = static_cast<std::uint64_t>(header.rows) *
+                              static_cast<std::uint64_t>(header.cols) *
+                              sizeof(T);
+  if (header.offset > file_size || bytes != file_size - header.offset) {
+    throw std::invalid_argument("Invalid matrix file.");
+  }
+  return static_cast<std::size_t>(bytes);
+}
+
+template <class T>
+Header MakeHeader(int rows, int cols) noexcept {
+  Header output{};
+  std::memcpy(output.magic, kMagic, sizeof(kMagic));
+  output.version = kVersion;
+  output.byte_order = kByteOrderMark;
+  output.element_type = ElementType<T>::kValue;
+  output.layout = kRowMajor;
+  output.alignment = kFileAlignment;
+  output.rows = rows;
+  output.cols = cols;
+  output.offset = sizeof(Header);
+  return output;
+}
+
+// Reads and checks the header of a file holding T elements.
+template <class T>
+Header ReadHeader(const File& file) {
+  const std::size_t size = file.Size();
+  if (size < sizeof(Header)) {
+    throw std::invalid_argument("Invalid matrix file.");
+  }
+  Header output{};
+  file.Read(&output, sizeof(output), 0);
+  CheckHeader<T>(output, size);
+  return output;
+}
+
+// Byte offset of element (i, j) in a file with the given header.
+std::size_t ElementOffset(const Header& header, int i, int j,
+                          std::size_t element_size) noexcept {
+  return header.offset +
+         (static_cast<std::size_t>(i) * header.cols + j) * element_size;
+}
+
+// Reads the rows x cols block at (row, col) of a matrix file into dst, whose
+// rows are ld elements apart, with one read per row or a single one for
+// whole rows.
+template <class T>
+void ReadTile(const File& file, const Header& header, int row, int col,
+              int rows, int cols, T* dst, int ld) {
+  if (cols == header.cols && ld == cols) {
+    file.Read(dst, static_cast<std::size_t>(rows) * cols * sizeof(T),
+              ElementOffset(header, row, 0, sizeof(T)));
+    return;
+  }
+  for (int i = 0; i < rows; ++i) {
+    file.Read(dst + static_cast<std::size_t>(i) * ld, cols * sizeof(T),
+              ElementOffset(header, row + i, col, sizeof(T)));
+  }
+}
+
+template <class T>
+void WriteTile(const File& file, const Header& header, int row, int col,
+               int rows, int cols, const T* src, int ld) {
+  for (int i = 0; i < rows; ++i) {
+    file.Write(src + static_cast<std::size_t>(i) * ld, cols * sizeof(T),
+               ElementOffset(header, row + i, col, sizeof(T)));
+  }
+}
+
+bool IsBlank(char c) noexcept { return c == ' ' || c == '\t'; }
+
+const char* SkipBlanks(const char* p, const char* end) noexcept {
+  while (p != end && IsBlank(*p)) ++p;
+  return p;
+}
+
+// Parses the elements of the line [begin, end) into row, which is left
+// empty for a blank line.
+template <class T>
+void ParseLine(const char* begin, const char* end, char delimiter,
+               std::vector<T>& row) {
+  if (begin != end && end[-1] == '\r') --end;
+  row.clear();
+  const char* p = SkipBlanks(begin, end);
+  while (p != end) {
+    // std::from_chars takes no explicit plus sign.
+    if (*p == '+') ++p;
+    T value = T();
+    const std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc() ||
+        (result.ptr != end && !IsBlank(*result.ptr) &&
+         *result.ptr != delimiter)) {
+      throw std::invalid_argument("Invalid matrix text.");
+    }
+    row.push_back(value);
+    p = SkipBlanks(result.ptr, end);
+    if (delimiter != ' ' && p != end) {
+      if (*p != delimiter) {
+        throw std::invalid_argument("Invalid matrix text.");
+      }
+      p = SkipBlanks(p + 1, end);
+      if (p == end) {
+        throw std::invalid_argument("Invalid matrix text.");
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// --------------------- SAVE AND LOAD ---------------------
+
+template <class T>
+void Save(const BasicMatrix<T>& matrix, const std::string& path) {
+  const Header header = MakeHeader<T>(matrix.GetRows(), matrix.GetCols());
+  File file(path, O_WRONLY | O_CREAT | O_TRUNC);
+  file.Write(&header, sizeof(header), 0);
+  file.Write(matrix.Data(),
+             static_cast<std::size_t>(matrix.GetRows()) * matrix.GetCols() *
+                 sizeof(T),
+             header.offset);
+}
+
+template <class T>
+BasicMatrix<T> Load(const std::string& path) {
+  File file(path, O_RDONLY);
+  const Header header = ReadHeader<T>(file);
+  BasicMatrix<T> output(static_cast<int>(header.rows),
+                        static_cast<int>(header.cols));
+  file.Read(output.Data(),
+            static_cast<std::size_t>(output.GetRows()) * output.GetCols() *
+                sizeof(T),
+            header.offset);
+  return output;
+}
+
+// --------------------- OUT OF CORE ---------------------
+
+// Steps run over the tiles (i, j) of C with the inner tile index p fastest,
+// so each C tile is complete, and written out, before the next one starts.
+// The prefetch thread reads step s + 1 into buffer (s + 1) % 2 while step s
+// multiplies from the other. C is opened without truncation and checked
+// against the inputs first, so passing an input as the output throws
+// instead of wiping it.
+template <class T>
+void MultiplyFiles(const std::string& a_path, const std::string& b_path,
+                   const std::string& c_path, std::size_t memory_budget) {
+  const File a_file(a_path, O_RDONLY);
+  const File b_file(b_path, O_RDONLY);
+  const Header a = ReadHeader<T>(a_file);
+  const Header b = ReadHeader<T>(b_file);
+  if (a.cols != b.rows) {
+    throw std::invalid_argument(
+        "The number of columns of the first matrix is not equal to the number "
+        "of rows of the second matrix.");
+  }
+  const std::size_t budget_tile = static_cast<std::size_t>(
+      std::sqrt(static_cast<double>(memory_budget / (5 * sizeof(T)))));
+  if (budget_tile == 0) {
+    throw std::invalid_argument("Memory budget too small.");
+  }
+  if (!Addressable(a.rows, b.cols)) {
+    throw std::invalid_argument("Matrix too large.");
+  }
+  const int m = static_cast<int>(a.rows);
+  const int k = static_cast<int>(a.cols);
+  const int n = static_cast<int>(b.cols);
+  const File c_file(c_path, O_RDWR | O_CREAT);
+  if (c_file.SameFile(a_file) || c_file.SameFile(b_file)) {
+    throw std::invalid_argument("The output file is an input file.");
+  }
+  c_file.Resize(0);
+  const Header c = MakeHeader<T>(m, n);
+  c_file.Write(&c, sizeof(c), 0);
+  c_file.Resize(ElementOffset(c, m, 0, sizeof(T)));
+  if (m == 0 || n == 0 || k == 0) return;
+
+  const int tile = static_cast<int>(
+      std::min<std::size_t>(budget_tile, std::max({m, n, k})));
+  const int tile_m = std::min(tile, m);
+  const int tile_k = std::min(tile, k);
+  const int tile_n = std::min(tile, n);
+  const int tiles_k = (k + tile_k - 1) / tile_k;
+  const int tiles_n = (n + tile_n - 1) / tile_n;
+  const int steps = (m + tile_m - 1) / tile_m * tiles_n * tiles_k;
+  BasicMatrix<T> a_tiles[2] = {BasicMatrix<T>(tile_m, tile_k),
+                               BasicMatrix<T>(tile_m, tile_k)};
+  BasicMatrix<T> b_tiles[2] = {BasicMatrix<T>(tile_k, tile_n),
+                               BasicMatrix<T>(tile_k, tile_n)};
+  BasicMatrix<T> c_tile(tile_m, tile_n);
+
+  struct Step {
+    int row, inner, col;
+    int rows, depth, cols;
+    bool last;
+  };
+  auto step = [&](int s) {
+    const int p = s % tiles_k;
+    const int j = s / tiles_k % tiles_n;
+    const int i = s / tiles_k / tiles_n;
+    Step output{i * tile_m, p * tile_k, j * tile_n, 0, 0, 0, p + 1 == tiles_k};
+    output.rows = std::min(tile_m, m - output.row);
+    output.depth = std::min(tile_k, k - output.inner);
+    output.cols = std::min(tile_n, n - output.col);
+    return output;
+  };
+  auto load = [&](int s) {
+    const Step t = step(s);
+    ReadTile(a_file, a, t.row, t.inner, t.rows, t.depth, a_tiles[s % 2].Data(),
+             tile_k);
+    ReadTile(b_file, b, t.inner, t.col, t.depth, t.cols, b_tiles[s % 2].Data(),
+             tile_n);
+  };
+  // Declared after everything load touches, so it is joined first.
+  Prefetcher prefetcher(load);
+  prefetcher.Start(0);
+  for (int s = 0; s < steps; ++s) {
+    prefetcher.Wait();
+    if (s + 1 < steps) prefetcher.Start(s + 1);
+    const Step t = step(s);
+    Gemm(T(1),
+         BasicMatrixView<const T>(a_tiles[s % 2].Data(), t.rows, t.depth,
+                                  tile_k),
+         false,
+         BasicMatrixView<const T>(b_tiles[s % 2].Data(), t.depth, t.cols,
+                                  tile_n),
+         false, t.inner == 0 ? T(0) : T(1),
+         BasicMatrixView<T>(c_tile.Data(), t.rows, t.cols, tile_n));
+    if (t.last) {
+      WriteTile(c_file, c, t.row, t.col, t.rows, t.cols, c_tile.Data(),
+                tile_n);
+    }
+  }
+}
+
+// --------------------- TEXT ---------------------
+
+// Complete lines are parsed straight out of the chunk buffer; the partial
+// line at its end is moved to the front and completed by the next read. A
+// line longer than the buffer doubles it.
+template <class T>
+BasicMatrix<T> ReadText(std::istream& in, char delimiter) {
+  BasicMatrix<T> output;
+  int reserved = 0;
+  std::vector<T> row;
+  auto append = [&](const char* begin, const char* end) {
+    ParseLine(begin, end, delimiter, row);
+    if (row.empty()) return;
+    const int rows = output.GetRows();
+    const int cols = static_cast<int>(row.size());
+    if (rows == 0) {
+      output.SetCols(cols);
+    } else if (cols != output.GetCols()) {
+      throw std::invalid_argument("Different matrix dimensions.");
+    }
+    if (rows == reserved) {
+      reserved = std::max(16, 2 * rows);
+      output.ReserveRows(reserved);
+    }
+    output.SetRows(rows + 1);
+    std::copy(row.begin(), row.end(), output.Data() + rows * cols);
+  };
+  std::vector<char> buffer(kTextChunk);
+  std::size_t filled = 0;
+  bool done = false;
+  while (!done) {
+    in.read(buffer.data() + filled, buffer.size() - filled);
+    filled += static_cast<std::size_t>(in.gcount());
+    if (in.bad()) {
+      throw std::runtime_error("Cannot read the stream.");
+    }
+    done = !in;
+    const char* begin = buffer.data();
+    const char* end = begin + filled;
+    const char* line_end = nullptr;
+    while ((line_end = static_cast<const char*>(
+                std::memchr(begin, '\n', end - begin))) != nullptr) {
+      append(begin, line_end);
+      begin = line_end + 1;
+    }
+    if (done) {
+      append(begin, end);
+    } else if (begin == buffer.data()) {
+      buffer.resize(buffer.size() * 2);
+    } else {
+      filled = end - begin;
+      std::memmove(buffer.data(), begin, filled);
+    }
+  }
+  return output;
+}
+
+template <class T>
+void WriteText(const BasicMatrix<T>& matrix, std::ostream& out,
+               char delimiter) {
+  std::vector<char> buffer(kTextChunk);
+  char* const first = buffer.data();
+  char* const last = first + buffer.size();
+  char* next = first;
+  const int rows = matrix.GetRows();
+  const int cols = matrix.GetCols();
+  const T* data = matrix.Data();
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      if (static_cast<std::size_t>(last - next) < kMaxNumberText) {
+        out.write(first, next - first);
+        next = first;
+      }
+      next = std::to_chars(next, last, data[i * cols + j]).ptr;
+      *next++ = (j + 1 == cols) ? '\n' : delimiter;
+    }
+  }
+  out.write(first, next - first);
+  if (!out) {
+    throw std::runtime_error("Cannot write the stream.");
+  }
+}
+
+// --------------------- MAPPED MATRIX ---------------------
+
+template <class T>
+BasicMappedMatrix<T>::BasicMappedMatrix() noexcept
+    : mapping_(nullptr), length_(0), data_(nullptr), rows_(0), cols_(0) {}
+
+template <class T>
+BasicMappedMatrix<T>::BasicMappedMatrix(const std::string& path)
+    : BasicMappedMatrix() {
+  const File file(path, O_RDONLY);
+  const std::size_t size = file.Size();
+  if (size < sizeof(Header)) {
+    throw std::invalid_argument("Invalid matrix file.");
+  }
+  void* mapping =
+      ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.Descriptor(), 0);
+  if (mapping == MAP_FAILED) ThrowSystemError("Cannot map", path);
+  // The object is constructed once the delegated constructor returns, so the
+  // destructor unmaps the file if the header check throws.
+  mapping_ = mapping;
+  length_ = size;
+  const Header& header = *static_cast<const Header*>(mapping_);
+  CheckHeader<T>(header, size);
+  data_ = reinterpret_cast<const T*>(static_cast<const char*>(mapping_) +
+                                     header.offset);
+  rows_ = static_cast<int>(header.rows);
+  cols_ = static_cast<int>(header.cols);
+}
+
+template <class T>
+BasicMappedMatrix<T>::~BasicMappedMatrix() {
+  Unmap();
+}
+
+template <class T>
+BasicMappedMatrix<T>::BasicMappedMatrix(BasicMappedMatrix&& other) noexcept
+    : BasicMappedMatrix() {
+  *this = std::move(other);
+}
+
+template <class T>
+BasicMappedMatrix<T>& BasicMappedMatrix<T>::operator=(
+    BasicMappedMatrix&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    std::swap(mapping_, other.mapping_);
+    std::swap(length_, other.length_);
+    std::swap(data_, other.data_);
+    std::swap(rows_, other.rows_);
+    std::swap(cols_, other.cols_);
+  }
+  return *this;
+}
+
+template <class T>
+int BasicMappedMatrix<T>::GetRows() const noexcept {
+  return rows_;
+}
+
+template <class T>
+int BasicMappedMatrix<T>::GetCols() const noexcept {
+  return cols_;
+}
+
+template <class T>
+const T* BasicMappedMatrix<T>::Data() const noexcept {
+  return data_;
+}
+
+template <class T>
+BasicMatrixView<const T> BasicMappedMatrix<T>::View() const noexcept {
+  return BasicMatrixView<const T>(data_, rows_, cols_, cols_);
+}
+
+template <class T>
+void BasicMappedMatrix<T>::Unmap() noexcept {
+  if (mapping_ != nullptr) {
+    ::munmap(mapping_, length_);
+  }
+  mapping_ = nullptr;
+  length_ = 0;
+  data_ = nullptr;
+  rows_ = 0;
+  cols_ = 0;
+}
+
+template void Save<float>(const FloatMatrix&, const std::string&);
+template void Save<double>(const Matrix&, const std::string&);
+template void Save<std::complex<double>>(const ComplexMatrix&,
+                                         const std::string&);
+template FloatMatrix Load<float>(const std::string&);
+template Matrix Load<double>(const std::string&);
+template ComplexMatrix Load<std::complex<double>>(const std::string&);
+
+template void MultiplyFiles<float>(const std::string&, const std::string&,
+                                   const std::string&, std::size_t);
+template void MultiplyFiles<double>(const std::string&, const std::string&,
+                                    const std::string&, std::size_t);
+template void MultiplyFiles<std::complex<double>>(const std::string&,
+                                                  const std::string&,
+                                                  const std::string&,
+                                                  std::size_t);
+template FloatMatrix ReadText<float>(std::istream&, char);
+template Matrix ReadText<double>(std::istream&, char);
+template void WriteText<float>(const FloatMatrix&, std::ostream&, char);
+template void WriteText<double>(const Matrix&, std::ostream&, char);
+
+template class BasicMappedMatrix<float>;
+template class BasicMappedMatrix<double>;
+template class BasicMappedMatrix<std::complex<double>>;
+
+}  // namespace io
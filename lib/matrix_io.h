@@ -0,0 +1,107 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_IO_H_
+#define _MATRIX_OOP_LIB__MATRIX_IO_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+#include "matrix_oop.h"
+#include "matrix_view.h"
+
+// Binary matrix files. A file is a 64-byte header followed by the elements
+// in row-major order, native byte order, starting at an offset that is a
+// multiple of kFileAlignment. The header holds, in native byte order:
+//   char[8] magic "MATRIXB", uint32 version, uint32 byte order mark
+//   0x01020304, uint32 element type (1 float, 2 double, 3 complex double),
+//   uint32 layout (0 row-major), uint32 alignment, 4 reserved bytes,
+//   int64 rows, int64 cols, uint64 offset of the elements, 8 reserved bytes.
+// Malformed files, among them files whose length is not the header offset
+// plus the elements and headers of more than INT_MAX elements, and element
+// type mismatches throw std::invalid_argument, failing system calls
+// std::system_error.
+namespace io {
+
+const std::size_t kFileAlignment = 64;
+
+// Writes matrix to path, replacing the file. The elements go out straight
+// from the matrix buffer in large chunks.
+template <class T>
+void Save(const BasicMatrix<T> &matrix, const std::string &path);
+
+// Reads the whole file into a new matrix.
+template <class T>
+BasicMatrix<T> Load(const std::string &path);
+
+// Out-of-core product C = A * B of two matrix files, written to c_path. The
+// matrices stay on disk and are streamed through square tiles: for every
+// tile of C the tiles of A and B along the inner dimension are multiplied
+// into it, and the tiles of the next step are read by a background thread
+// while the current ones are multiplied. The tiles are sized so that the
+// double-buffered A and B tiles and the C tile, five in all, fit in
+// memory_budget bytes; the GEMM kernel's packing buffers come on top. A
+// budget below five elements or a C of more than INT_MAX elements throws
+// std::invalid_argument.
+template <class T>
+void MultiplyFiles(const std::string &a_path, const std::string &b_path,
+                   const std::string &c_path, std::size_t memory_budget);
+
+// Text matrices, one row per line with elements separated by delimiter; a
+// delimiter of ' ' stands for any run of spaces and tabs, as in
+// whitespace-separated files. Blanks around elements, empty lines and CRLF
+// line ends are accepted. Instantiated for float and double.
+//
+// ReadText consumes the stream in large chunks, converts the numbers with
+// std::from_chars and appends rows to the result as they are parsed,
+// reserving row capacity geometrically; the result may keep up to twice the
+// storage it needs. Text that is not a number or a missing element throws
+// std::invalid_argument("Invalid matrix text."), rows of different lengths
+// "Different matrix dimensions.".
+template <class T>
+BasicMatrix<T> ReadText(std::istream &in, char delimiter = ',');
+
+// Writes the shortest text that reads back to the same value, formatted with
+// std::to_chars into a buffer that goes out in large chunks.
+template <class T>
+void WriteText(const BasicMatrix<T> &matrix, std::ostream &out,
+               char delimiter = ',');
+
+// Read-only, zero-copy matrix backed by a memory-mapped file: opening costs
+// one mmap regardless of size, and pages are read in by the kernel on first
+// access. The view stays valid as long as the object does.
+template <class T>
+class BasicMappedMatrix {
+ public:
+  BasicMappedMatrix() noexcept;
+  explicit BasicMappedMatrix(const std::string &path);
+  ~BasicMappedMatrix();
+
+  BasicMappedMatrix(BasicMappedMatrix &&other) noexcept;
+  BasicMappedMatrix &operator=(BasicMappedMatrix &&other) noexcept;
+  BasicMappedMatrix(const BasicMappedMatrix &) = delete;
+  BasicMappedMatrix &operator=(const BasicMappedMatrix &) = delete;
+
+  int GetRows() const noexcept;
+  int GetCols() const noexcept;
+  const T *Data() const noexcept;
+  BasicMatrixView<const T> View() const noexcept;
+
+ private:
+  void *mapping_;
+  std::size_t length_;
+  const T *data_;
+  int rows_, cols_;
+
+  void Unmap() noexcept;
+};
+
+using MappedMatrix = BasicMappedMatrix<double>;
+using FloatMappedMatrix = BasicMappedMatrix<float>;
+using ComplexMappedMatrix = BasicMappedMatrix<std::complex<double>>;
+
+extern template class BasicMappedMatrix<float>;
+extern template class BasicMappedMatrix<double>;
+extern template class BasicMappedMatrix<std::complex<double>>;
+
+}  // namespace io
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_IO_H_
@@ -0,0 +1,323 @@
+#include "matrix_oop.h"
+
+#include <algorithm>
+
+#include "matrix_gemm.h"
+#include "matrix_threads.h"
+
+namespace {
+
+// Column width of the panels factored between two trailing GEMM updates.
+const int kPanel = 64;
+// Smallest column range of a right-hand side handed to one thread.
+const int kSolveColumns = 64;
+
+}  // namespace
+
+// --------------------- CREATION ---------------------
+
+template <class T>
+BasicLuFactor<T>::BasicLuFactor() noexcept : lu_(), pivots_(), sign_(1) {}
+
+// Right-looking blocked LU. Each kPanel-wide column panel is factored with
+// unblocked partial pivoting, the matching block row of U is obtained by a
+// unit lower triangular solve, and the trailing submatrix is updated by the
+// (threaded) GEMM kernel, which carries almost all of the O(n^3) work.
+template <class T>
+void BasicLuFactor<T>::Factorize(const BasicMatrix<T>& matrix) {
+  lu_ = matrix;
+  const int n = lu_.rows_;
+  pivots_.assign(n, 0);
+  sign_ = 1;
+  for (int kb = 0; kb < n; kb += kPanel) {
+    const int panel_end = std::min(kb + kPanel, n);
+    for (int k = kb; k < panel_end; ++k) {
+      int pivot_row = k;
+      Real pivot_abs = std::abs(lu_.Row(k)[k]);
+      for (int i = k + 1; i < n; ++i) {
+        Real candidate = std::abs(lu_.Row(i)[k]);
+        if (candidate > pivot_abs) {
+          pivot_abs = candidate;
+          pivot_row = i;
+        }
+      }
+      pivots_[k] = pivot_row;
+      if (pivot_row != k) {
+        std::swap_ranges(lu_.Row(k), lu_.Row(k) + n, lu_.Row(pivot_row));
+        sign_ = -sign_;
+      }
+      const T* pivot = lu_.Row(k);
+      if (pivot[k] == T()) continue;
+      for (int i = k + 1; i < n; ++i) {
+        T* row = lu_.Row(i);
+        const T l_ik = row[k] / pivot[k];
+        row[k] = l_ik;
+        if (l_ik == T()) continue;
+        for (int j = k + 1; j < panel_end; ++j) {
+          row[j] -= l_ik * pivot[j];
+        }
+      }
+    }
+    if (panel_end == n) break;
+    const int width = n - panel_end;
+    for (int i = kb + 1; i < panel_end; ++i) {
+      T* row = lu_.Row(i);
+      for (int k = kb; k < i; ++k) {
+        const T l_ik = row[k];
+        if (l_ik == T()) continue;
+        const T* u = lu_.Row(k) + panel_end;
+        for (int j = 0; j < width; ++j) {
+          row[panel_end + j] -= l_ik * u[j];
+        }
+      }
+    }
+    T* trailing = lu_.Row(panel_end) + panel_end;
+    gemm::Multiply(width, width, panel_end - kb, T(-1),
+                   lu_.Row(panel_end) + kb, n, lu_.Row(kb) + panel_end, n,
+                   trailing, n);
+  }
+}
+
+// --------------------- ACCESSORS ---------------------
+
+template <class T>
+const BasicMatrix<T>& BasicLuFactor<T>::GetLu() const noexcept { return lu_; }
+
+template <class T>
+const std::vector<int>& BasicLuFactor<T>::GetPivots() const noexcept {
+  return pivots_;
+}
+
+template <class T>
+int BasicLuFactor<T>::GetSize() const noexcept { return lu_.rows_; }
+
+// Relative to the largest pivot, so a uniformly scaled matrix is judged the
+// same way whatever the scale, as in BasicQrFactor::Solve.
+template <class T>
+bool BasicLuFactor<T>::IsSingular() const noexcept {
+  Real min_pivot = 0;
+  Real max_pivot = 0;
+  for (int k = 0; k < lu_.rows_; ++k) {
+    Real pivot = std::abs(lu_.Row(k)[k]);
+    if (k == 0 || pivot < min_pivot) min_pivot = pivot;
+    if (pivot > max_pivot) max_pivot = pivot;
+  }
+  const bool negligible =
+      !(min_pivot > MatrixTraits<T>::kTolerance * max_pivot);
+  return lu_.rows_ > 0 && negligible;
+}
+
+// --------------------- OPERATIONS ---------------------
+
+template <class T>
+T BasicLuFactor<T>::Determinant() const noexcept {
+  T result = sign_;
+  for (int k = 0; k < lu_.rows_; ++k) {
+    result *= lu_.Row(k)[k];
+  }
+  return result;
+}
+
+template <class T>
+BasicMatrix<T> BasicLuFactor<T>::Inverse() const {
+  const int n = lu_.rows_;
+  BasicMatrix<T> result(n, n);
+  for (int i = 0; i < n; ++i) {
+    result.Row(i)[i] = 1;
+  }
+  SolveInPlace(result);
+  return result;
+}
+
+template <class T>
+BasicMatrix<T> BasicLuFactor<T>::Solve(const BasicMatrix<T>& rhs) const {
+  if (rhs.rows_ != lu_.rows_) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  if (IsSingular()) {
+    throw std::invalid_argument("The matrix determinant is 0.");
+  }
+  if (lu_.rows_ == 0) {
+    // Copying would drop the column count of an empty rhs.
+    return BasicMatrix<T>(0, rhs.cols_);
+  }
+  BasicMatrix<T> result(rhs);
+  SolveInPlace(result);
+  return result;
+}
+
+template <class T>
+BasicMatrix<T> Solve(const BasicMatrix<T>& a, const BasicMatrix<T>& b) {
+  return a.Lu().Solve(b);
+}
+
+// --------------------- UTILS ---------------------
+
+// Overwrites rhs with the solution X of A * X = rhs. Rows of rhs are updated
+// as whole contiguous vectors, so every substitution step is a streaming axpy.
+template <class T>
+void BasicLuFactor<T>::SolveInPlace(BasicMatrix<T>& rhs) const {
+  const int n = lu_.rows_;
+  const int m = rhs.cols_;
+  for (int k = 0; k < n; ++k) {
+    if (pivots_[k] != k) {
+      std::swap_ranges(rhs.Row(k), rhs.Row(k) + m, rhs.Row(pivots_[k]));
+    }
+  }
+  // Columns of rhs are independent systems, so threads take column ranges.
+  threads::ParallelFor(m, kSolveColumns, [&](int begin, int end) {
+    for (int i = 1; i < n; ++i) {
+      const T* l = lu_.Row(i);
+      T* x = rhs.Row(i);
+      for (int k = 0; k < i; ++k) {
+        const T l_ik = l[k];
+        if (l_ik == T()) continue;
+        const T* y = rhs.Row(k);
+        for (int j = begin; j < end; ++j) {
+          x[j] -= l_ik * y[j];
+        }
+      }
+    }
+    for (int i = n - 1; i >= 0; --i) {
+      const T* u = lu_.Row(i);
+      T* x = rhs.Row(i);
+      for (int k = i + 1; k < n; ++k) {
+        const T u_ik = u[k];
+        if (u_ik == T()) continue;
+        const T* y = rhs.Row(k);
+        for (int j = begin; j < end; ++j) {
+          x[j] -= u_ik * y[j];
+        }
+      }
+      const T inverse_pivot = T(1) / u[i];
+      for (int j = begin; j < end; ++j) {
+        x[j] *= inverse_pivot;
+      }
+    }
+  });
+}
+
+// Cofactor matrix of a singular or nearly singular matrix through a
+// rank-revealing LU with complete pivoting, P * A * Q = L * U. Then
+// adj(A) = det(P) * det(Q) * Q * adj(U) * inv(L) * P, and adj(U) has a closed
+// form as long as only the last pivot of U vanishes:
+//   adj(U) = | u_nn * d * inv(U11)   -d * inv(U11) * u12 |
+//            | 0                      d                  |,
+// d = u_11 * ... * u_(n-1)(n-1). A matrix of rank below n - 1 has adj(A) = 0.
+template <class T>
+BasicMatrix<T> BasicLuFactor<T>::SingularComplements(
+    const BasicMatrix<T>& matrix) {
+  const int n = matrix.rows_;
+  BasicMatrix<T> result(n, n);
+  BasicMatrix<T> lu = matrix;
+  std::vector<int> row_perm(n), col_perm(n);
+  for (int k = 0; k < n; ++k) {
+    row_perm[k] = col_perm[k] = k;
+  }
+  T sign = 1;
+  for (int k = 0; k < n; ++k) {
+    int pivot_row = k, pivot_col = k;
+    Real pivot_abs = 0;
+    for (int i = k; i < n; ++i) {
+      const T* row = lu.Row(i);
+      for (int j = k; j < n; ++j) {
+        if (std::abs(row[j]) > pivot_abs) {
+          pivot_abs = std::abs(row[j]);
+          pivot_row = i;
+          pivot_col = j;
+        }
+      }
+    }
+    if (pivot_row != k) {
+      std::swap_ranges(lu.Row(k), lu.Row(k) + n, lu.Row(pivot_row));
+      std::swap(row_perm[k], row_perm[pivot_row]);
+      sign = -sign;
+    }
+    if (pivot_col != k) {
+      for (int i = 0; i < n; ++i) {
+        std::swap(lu.Row(i)[k], lu.Row(i)[pivot_col]);
+      }
+      std::swap(col_perm[k], col_perm[pivot_col]);
+      sign = -sign;
+    }
+    if (pivot_abs == 0) break;
+    const T* pivot = lu.Row(k);
+    for (int i = k + 1; i < n; ++i) {
+      T* row = lu.Row(i);
+      const T l_ik = row[k] / pivot[k];
+      row[k] = l_ik;
+      for (int j = k + 1; j < n; ++j) {
+        row[j] -= l_ik * pivot[j];
+      }
+    }
+  }
+
+  const Real tolerance =
+      MatrixTraits<T>::kTolerance * std::abs(lu.Row(0)[0]);
+  if (n > 1 && std::abs(lu.Row(n - 2)[n - 2]) <= tolerance) return result;
+
+  // adj(U) is upper triangular; build it in place of `adjugate`.
+  const int m = n - 1;
+  T d = 1;
+  for (int k = 0; k < m; ++k) {
+    d *= lu.Row(k)[k];
+  }
+  const T u_nn = lu.Row(m)[m];
+  BasicMatrix<T> adjugate(n, n);
+  for (int j = 0; j < m; ++j) {
+    // Column j of inv(U11) by back substitution.
+    T* column = adjugate.Row(m);
+    std::fill(column, column + m, T());
+    column[j] = 1;
+    for (int i = j; i >= 0; --i) {
+      const T* u = lu.Row(i);
+      T value = column[i];
+      for (int k = i + 1; k <= j; ++k) {
+        value -= u[k] * column[k];
+      }
+      column[i] = value / u[i];
+    }
+    for (int i = 0; i <= j; ++i) {
+      adjugate.Row(i)[j] = u_nn * d * column[i];
+    }
+  }
+  for (int i = m - 1; i >= 0; --i) {
+    const T* u = lu.Row(i);
+    T value = -d * u[m];
+    for (int k = i + 1; k < m; ++k) {
+      value -= u[k] * adjugate.Row(k)[m];
+    }
+    adjugate.Row(i)[m] = value / u[i];
+  }
+  std::fill(adjugate.Row(m), adjugate.Row(m) + m, T());
+  adjugate.Row(m)[m] = d;
+
+  // adj(U) * inv(L): solve X * L = adj(U) column by column from the right.
+  for (int j = n - 2; j >= 0; --j) {
+    for (int i = 0; i < n; ++i) {
+      T* row = adjugate.Row(i);
+      T value = row[j];
+      for (int k = j + 1; k < n; ++k) {
+        value -= row[k] * lu.Row(k)[j];
+      }
+      row[j] = value;
+    }
+  }
+
+  for (int i = 0; i < n; ++i) {
+    const T* row = adjugate.Row(i);
+    for (int j = 0; j < n; ++j) {
+      result.Row(row_perm[j])[col_perm[i]] = sign * row[j];
+    }
+  }
+  return result;
+}
+
+template FloatMatrix Solve<float>(const FloatMatrix&, const FloatMatrix&);
+template Matrix Solve<double>(const Matrix&, const Matrix&);
+template ComplexMatrix Solve<std::complex<double>>(const ComplexMatrix&,
+                                                   const ComplexMatrix&);
+
+template class BasicLuFactor<float>;
+template class BasicLuFactor<double>;
+template class BasicLuFactor<std::complex<double>>;
@@ -0,0 +1,166 @@
+#include "matrix_memory.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace memory {
+
+namespace {
+
+thread_local std::pmr::memory_resource* current_resource = nullptr;
+
+}  // namespace
+
+std::pmr::memory_resource* GetResource() noexcept {
+  std::pmr::memory_resource* output = current_resource;
+  if (output == nullptr) {
+    output = std::pmr::new_delete_resource();
+  }
+  return output;
+}
+
+// --------------------- SCOPED RESOURCE ---------------------
+
+ScopedResource::ScopedResource(std::pmr::memory_resource* resource) noexcept
+    : previous_(current_resource) {
+  current_resource = resource;
+}
+
+ScopedResource::~ScopedResource() { current_resource = previous_; }
+
+// --------------------- ARENA ---------------------
+
+ArenaResource::ArenaResource(std::size_t initial_size,
+                             std::pmr::memory_resource* upstream)
+    : upstream_(upstream),
+      chunks_(),
+      next_size_(std::max<std::size_t>(initial_size, kAlignment)),
+      used_(0),
+      current_(nullptr),
+      end_(nullptr) {}
+
+ArenaResource::~ArenaResource() {
+  for (const Chunk& chunk : chunks_) {
+    upstream_->deallocate(chunk.data, chunk.size, kAlignment);
+  }
+}
+
+void ArenaResource::Release() noexcept {
+  if (!chunks_.empty()) {
+    Chunk largest = chunks_.back();
+    chunks_.pop_back();
+    for (const Chunk& chunk : chunks_) {
+      upstream_->deallocate(chunk.data, chunk.size, kAlignment);
+    }
+    chunks_.assign(1, largest);
+    current_ = largest.data;
+    end_ = largest.data + largest.size;
+  }
+  used_ = 0;
+}
+
+std::size_t ArenaResource::GetUsed() const noexcept { return used_; }
+
+void* ArenaResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+  std::size_t space = end_ - current_;
+  void* output = current_;
+  if (current_ == nullptr ||
+      std::align(alignment, bytes, output, space) == nullptr) {
+    // Chunks are kAlignment aligned, so the padding below covers any
+    // alignment up to kAlignment and over-aligned requests still fit.
+    const std::size_t needed = bytes + std::max(alignment, kAlignment);
+    while (next_size_ < needed) next_size_ *= 2;
+    Chunk chunk = {static_cast<char*>(
+                       upstream_->allocate(next_size_, kAlignment)),
+                   next_size_};
+    chunks_.push_back(chunk);
+    next_size_ *= 2;
+    current_ = chunk.data;
+    end_ = chunk.data + chunk.size;
+    space = chunk.size;
+    output = current_;
+    std::align(alignment, bytes, output, space);
+  }
+  current_ = static_cast<char*>(output) + bytes;
+  used_ += bytes;
+  return output;
+}
+
+void ArenaResource::do_deallocate(void*, std::size_t, std::size_t) {}
+
+bool ArenaResource::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+// --------------------- POOL ---------------------
+
+PoolResource::PoolResource(std::pmr::memory_resource* upstream)
+    : upstream_(upstream), blocks_(), free_lists_() {}
+
+PoolResource::~PoolResource() { Release(); }
+
+void PoolResource::Release() noexcept {
+  for (const Block& block : blocks_) {
+    upstream_->deallocate(block.data, std::size_t(1) << block.size_class,
+                          kAlignment);
+  }
+  blocks_.clear();
+  for (std::vector<void*>& list : free_lists_) {
+    list.clear();
+  }
+}
+
+std::size_t PoolResource::GetBlockCount() const noexcept {
+  return blocks_.size();
+}
+
+int PoolResource::SizeClass(std::size_t bytes,
+                            std::size_t alignment) noexcept {
+  int output = -1;
+  if (alignment <= kAlignment && bytes <= (std::size_t(1) << kMaxClass)) {
+    output = kMinClass;
+    while ((std::size_t(1) << output) < bytes) ++output;
+  }
+  return output;
+}
+
+void* PoolResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+  const int size_class = SizeClass(bytes, alignment);
+  void* output = nullptr;
+  if (size_class < 0) {
+    output = upstream_->allocate(bytes, alignment);
+  } else if (free_lists_[size_class - kMinClass].empty()) {
+    // Room for every block the pool owns, so do_deallocate never allocates.
+    free_lists_[size_class - kMinClass].reserve(blocks_.size() + 1);
+    output = upstream_->allocate(std::size_t(1) << size_class, kAlignment);
+    try {
+      blocks_.push_back(Block{output, size_class});
+    } catch (...) {
+      // Not recorded, so Release() would never return it.
+      upstream_->deallocate(output, std::size_t(1) << size_class, kAlignment);
+      throw;
+    }
+  } else {
+    output = free_lists_[size_class - kMinClass].back();
+    free_lists_[size_class - kMinClass].pop_back();
+  }
+  return output;
+}
+
+void PoolResource::do_deallocate(void* p, std::size_t bytes,
+                                 std::size_t alignment) {
+  const int size_class = SizeClass(bytes, alignment);
+  if (size_class < 0) {
+    upstream_->deallocate(p, bytes, alignment);
+  } else {
+    free_lists_[size_class - kMinClass].push_back(p);
+  }
+}
+
+bool PoolResource::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+}  // namespace memory
@@ -0,0 +1,121 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_MEMORY_H_
+#define _MATRIX_OOP_LIB__MATRIX_MEMORY_H_
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace memory {
+
+// Alignment of every matrix buffer. The SIMD kernels use unaligned loads, so
+// this is the alignment of plain operator new, which keeps the default
+// resource on the fast, non-aligned allocation path.
+const std::size_t kAlignment = alignof(std::max_align_t);
+
+// Resource new matrices of the calling thread allocate from. Defaults to
+// std::pmr::new_delete_resource(); changed for a scope by ScopedResource.
+std::pmr::memory_resource *GetResource() noexcept;
+
+// Makes resource the current one of the calling thread for the lifetime of
+// the object and restores the previous one on destruction. Scopes nest.
+// A matrix keeps the resource it was allocated from, so the resource must
+// outlive every matrix created inside the scope.
+class ScopedResource {
+ public:
+  explicit ScopedResource(std::pmr::memory_resource *resource) noexcept;
+  ~ScopedResource();
+
+  ScopedResource(const ScopedResource &) = delete;
+  ScopedResource &operator=(const ScopedResource &) = delete;
+
+ private:
+  std::pmr::memory_resource *previous_;
+};
+
+// Bump-pointer arena. Allocation advances a pointer inside the current chunk
+// and deallocation is a no-op; memory is reclaimed all at once by Release()
+// or by the destructor. Chunks come from upstream and double in size when
+// the current one is exhausted. Not thread safe.
+class ArenaResource : public std::pmr::memory_resource {
+ public:
+  explicit ArenaResource(
+      std::size_t initial_size = 1 << 16,
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+  ~ArenaResource() override;
+
+  ArenaResource(const ArenaResource &) = delete;
+  ArenaResource &operator=(const ArenaResource &) = delete;
+
+  // Rewinds the arena. Only the largest chunk is kept, so a computation that
+  // is repeated after Release() no longer reaches the upstream resource.
+  void Release() noexcept;
+  // Bytes handed out since construction or the last Release().
+  std::size_t GetUsed() const noexcept;
+
+ private:
+  struct Chunk {
+    char *data;
+    std::size_t size;
+  };
+
+  std::pmr::memory_resource *upstream_;
+  std::vector<Chunk> chunks_;
+  std::size_t next_size_;
+  std::size_t used_;
+  char *current_;
+  char *end_;
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void *p, std::size_t bytes,
+                     std::size_t alignment) override;
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override;
+};
+
+// Size-class pool. Requests are rounded up to a power of two between 64 bytes
+// and 64 MiB, and freed blocks go to a per-class free list from which later
+// requests of the same class are served, so a loop that keeps producing
+// same-sized temporaries stops reaching upstream after its first iteration.
+// Larger or over-aligned requests go straight to upstream. Blocks return to
+// upstream on Release() or destruction. Not thread safe.
+class PoolResource : public std::pmr::memory_resource {
+ public:
+  explicit PoolResource(
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+  ~PoolResource() override;
+
+  PoolResource(const PoolResource &) = delete;
+  PoolResource &operator=(const PoolResource &) = delete;
+
+  // Returns every block owned by the pool to upstream. Memory still in use
+  // by live matrices is freed as well.
+  void Release() noexcept;
+  // Number of blocks the pool requested from upstream.
+  std::size_t GetBlockCount() const noexcept;
+
+ private:
+  static const int kMinClass = 6;
+  static const int kMaxClass = 26;
+  static const int kNumClasses = kMaxClass - kMinClass + 1;
+
+  struct Block {
+    void *data;
+    int size_class;
+  };
+
+  std::pmr::memory_resource *upstream_;
+  std::vector<Block> blocks_;
+  std::vector<void *> free_lists_[kNumClasses];
+
+  static int SizeClass(std::size_t bytes, std::size_t alignment) noexcept;
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void *p, std::size_t bytes,
+                     std::size_t alignment) override;
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override;
+};
+
+}  // namespace memory
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_MEMORY_H_
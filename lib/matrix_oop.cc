@@ -1,186 +1,275 @@
 #include "matrix_oop.h"
 
+#include <algorithm>
+#include <complex>
+
+#include "matrix_gemm.h"
+#include "matrix_memory.h"
+#include "matrix_simd.h"
+#include "matrix_view.h"
+
+namespace {
+
+// Side of the square tiles used by Transpose and TransposeInPlace.
+const int kTransposeTile = 32;
+
+}  // namespace
+
 // --------------------- CREATION AND DESTRUCTION ---------------------
 
-Matrix::Matrix(int rows_, int cols_)
-    : rows_(rows_), cols_(cols_), matrix_(nullptr) {
-  matrix_ = (double**)new double*[rows_];
-  for (int i = 0; i < rows_; ++i) {
-    try {
-      matrix_[i] = (double*)new double[cols_];
-    } catch (...) {
-      for (int j = 0; j < i; ++j) delete[] matrix_[j];
-      delete[] matrix_;
-      throw;
-    }
+template <class T>
+BasicMatrix<T>::BasicMatrix(int rows, int cols)
+    : rows_(rows),
+      cols_(cols),
+      matrix_(nullptr),
+      resource_(nullptr),
+      capacity_(0) {
+  if (rows_ < 0) {
+    throw std::invalid_argument("Number of rows less than 0.");
+  }
+  if (cols_ < 0) {
+    throw std::invalid_argument("Number of columns less than 0.");
   }
+  Allocate(Size());
   InitializeMatrix();
 }
 
-Matrix::Matrix() noexcept : rows_(0), cols_(0), matrix_(nullptr) {}
-
-Matrix::~Matrix() {
-  for (int i = 0; i < rows_; ++i) {
-    delete[] matrix_[i];
+template <class T>
+BasicMatrix<T>::BasicMatrix(int rows, int cols, Uninitialized)
+    : rows_(rows),
+      cols_(cols),
+      matrix_(nullptr),
+      resource_(nullptr),
+      capacity_(0) {
+  Allocate(Size());
+}
+
+template <class T>
+BasicMatrix<T>::BasicMatrix() noexcept
+    : rows_(0),
+      cols_(0),
+      matrix_(nullptr),
+      resource_(nullptr),
+      capacity_(0) {}
+
+template <class T>
+BasicMatrix<T>::~BasicMatrix() {
+  if (matrix_ != nullptr && !IsInline()) {
+    resource_->deallocate(matrix_, capacity_ * sizeof(T), memory::kAlignment);
   }
-  if (rows_ > 0) delete[] matrix_;
 }
 
 // --------------------- COPY AND MOVE ---------------------
-Matrix::Matrix(const Matrix& other) : rows_(0), cols_(0), matrix_(nullptr) {
+template <class T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix& other)
+    : rows_(0),
+      cols_(0),
+      matrix_(nullptr),
+      resource_(nullptr),
+      capacity_(0) {
   if (other.rows_ > 0 && other.cols_ > 0) {
-    Matrix result(other.rows_, other.cols_);
-    for (int i = 0; i < other.rows_; ++i) {
-      for (int j = 0; j < other.cols_; ++j) {
-        result.matrix_[i][j] = other.matrix_[i][j];
-      }
-    }
-    SwapMatrix(result);
+    Allocate(other.Size());
+    rows_ = other.rows_;
+    cols_ = other.cols_;
+    std::copy(other.matrix_, other.matrix_ + Size(), matrix_);
   }
 }
 
-Matrix::Matrix(Matrix&& other)
-    : rows_(other.rows_), cols_(other.cols_), matrix_(other.matrix_) {
+template <class T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& other)
+    : rows_(other.rows_),
+      cols_(other.cols_),
+      matrix_(other.matrix_),
+      resource_(other.resource_),
+      capacity_(other.capacity_) {
+  if (other.IsInline()) {
+    std::copy(other.inline_, other.inline_ + Size(), inline_);
+    matrix_ = inline_;
+  }
   other.rows_ = 0;
   other.cols_ = 0;
   other.matrix_ = nullptr;
+  other.resource_ = nullptr;
+  other.capacity_ = 0;
 }
 
 // --------------------- ACCESSORS AND MUTATORS ---------------------
 
-int Matrix::GetRows() const noexcept { return rows_; }
+template <class T>
+int BasicMatrix<T>::GetRows() const noexcept { return rows_; }
 
-int Matrix::GetCols() const noexcept { return cols_; }
+template <class T>
+int BasicMatrix<T>::GetCols() const noexcept { return cols_; }
 
-void Matrix::SetRows(const int new_rows) {
+template <class T>
+void BasicMatrix<T>::SetRows(const int new_rows) {
   if (new_rows < 0) {
     throw std::invalid_argument("Number of rows less than 0.");
   }
-  if (rows_ < new_rows) {
-    Matrix result(new_rows, cols_);
-    for (int i = 0; i < rows_; ++i) {
-      for (int j = 0; j < cols_; ++j) {
-        result.matrix_[i][j] = matrix_[i][j];
-      }
-    }
+  if (new_rows * cols_ > capacity_) {
+    BasicMatrix result(new_rows, cols_);
+    std::copy(matrix_, matrix_ + Size(), result.matrix_);
     SwapMatrix(result);
   } else {
-    for (int i = new_rows; i < rows_; ++i) {
-      delete[] matrix_[i];
+    // Rows are stored back to back, so the first new_rows rows are already
+    // laid out correctly and the tail of the buffer is simply left unused.
+    // Rows added back may hold leftovers of an earlier shrink.
+    if (new_rows > rows_) {
+      std::fill(matrix_ + Size(), matrix_ + new_rows * cols_, T());
     }
     rows_ = new_rows;
   }
 }
 
-void Matrix::SetCols(const int new_cols) {
+template <class T>
+void BasicMatrix<T>::ReserveRows(int rows) {
+  if (rows < 0) {
+    throw std::invalid_argument("Number of rows less than 0.");
+  }
+  if (rows * cols_ > capacity_) {
+    BasicMatrix result(rows, cols_, Uninitialized());
+    std::copy(matrix_, matrix_ + Size(), result.matrix_);
+    result.rows_ = rows_;
+    SwapMatrix(result);
+  }
+}
+
+template <class T>
+void BasicMatrix<T>::SetCols(const int new_cols) {
   if (new_cols < 0) {
     throw std::invalid_argument("Number of columns less than 0.");
   }
-  Matrix result(rows_, new_cols);
+  BasicMatrix result(rows_, new_cols);
   int cols = (cols_ < new_cols) ? cols_ : new_cols;
   for (int i = 0; i < rows_; ++i) {
-    for (int j = 0; j < cols; ++j) {
-      result.matrix_[i][j] = matrix_[i][j];
-    }
+    const T* src = Row(i);
+    std::copy(src, src + cols, result.Row(i));
   }
   SwapMatrix(result);
 }
 
 // --------------------- OPERATIONS ---------------------
-bool Matrix::EqMatrix(const Matrix& other) const { return *this == other; }
+template <class T>
+bool BasicMatrix<T>::EqMatrix(const BasicMatrix& other) const {
+  return *this == other;
+}
 
-void Matrix::SumMatrix(const Matrix& other) { *this += other; }
+template <class T>
+void BasicMatrix<T>::SumMatrix(const BasicMatrix& other) { *this += other; }
 
-void Matrix::SubMatrix(const Matrix& other) { *this -= other; }
+template <class T>
+void BasicMatrix<T>::SubMatrix(const BasicMatrix& other) { *this -= other; }
 
-void Matrix::MulNumber(const double num) { *this *= num; }
+template <class T>
+void BasicMatrix<T>::MulNumber(const T num) {
+  const int size = Size();
+  for (int k = 0; k < size; ++k) {
+    matrix_[k] *= num;
+  }
+}
 
-void Matrix::MulMatrix(const Matrix& other) { *this *= other; }
+template <class T>
+void BasicMatrix<T>::MulMatrix(const BasicMatrix& other) { *this *= other; }
+
+// Both transposes walk the matrix in kTransposeTile x kTransposeTile tiles,
+// so the strided side of each tile stays in cache while it is read or written.
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::Transpose() const {
+  return Transposed(matrix_, rows_, cols_, cols_);
+}
 
-Matrix Matrix::Transpose() const {
-  Matrix result(cols_, rows_);
-  for (int i = 0; i < cols_; ++i) {
-    for (int j = 0; j < rows_; ++j) {
-      result.matrix_[i][j] = matrix_[j][i];
+template <class T>
+void BasicMatrix<T>::TransposeInPlace() {
+  if (!SquareMatrix()) {
+    throw std::invalid_argument("The matrix is not square.");
+  }
+  const int n = rows_;
+  for (int ib = 0; ib < n; ib += kTransposeTile) {
+    const int i_end = std::min(ib + kTransposeTile, n);
+    for (int jb = ib; jb < n; jb += kTransposeTile) {
+      const int j_end = std::min(jb + kTransposeTile, n);
+      for (int i = ib; i < i_end; ++i) {
+        T* row = Row(i);
+        for (int j = (ib == jb) ? i + 1 : jb; j < j_end; ++j) {
+          std::swap(row[j], matrix_[j * n + i]);
+        }
+      }
     }
   }
-  return result;
 }
 
-Matrix Matrix::CalcComplements() const {
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::CalcComplements() const {
   if (rows_ == cols_ && cols_ == 0) {
     throw std::invalid_argument("The matrix is not initialised.");
   }
   if (!SquareMatrix()) {
     throw std::invalid_argument("The matrix is not square.");
   }
-  Matrix result(rows_, cols_);
-  MatrixMinors(result);
-  for (int i = 0; i < result.rows_; ++i) {
-    for (int j = 0; j < result.cols_; ++j) {
-      result.matrix_[i][j] *= pow(-1, i + j);
+  BasicMatrix result;
+  BasicLuFactor<T> lu = Lu();
+  if (!lu.IsSingular()) {
+    // C = det(A) * inv(A)^T, both taken from the same factorization.
+    const T determinant = lu.Determinant();
+    result = lu.Inverse();
+    result.TransposeInPlace();
+    T* data = result.matrix_;
+    for (int k = 0; k < result.Size(); ++k) {
+      data[k] *= determinant;
     }
+  } else {
+    result = BasicLuFactor<T>::SingularComplements(*this);
   }
   return result;
 }
 
-double Matrix::Determinant() const {
+template <class T>
+T BasicMatrix<T>::Determinant() const {
   if (!SquareMatrix()) {
     throw std::invalid_argument("The matrix is not square.");
   }
-  double result = 0;
-  Matrix matrix(rows_, cols_);
-  switch (rows_) {
-    case 1:
-      result = matrix_[0][0];
-      break;
-    case 2:
-      result = matrix_[0][0] * matrix_[1][1] - matrix_[0][1] * matrix_[1][0];
-      break;
-    default:
-      double res = 0;
-      for (int i = 0; i < rows_; ++i) {
-        matrix = CalcComplements();
-        res += matrix_[0][i] * matrix.matrix_[0][i];
-      }
-      result = res;
+  T result = T();
+  if (rows_ > 0) {
+    result = Lu().Determinant();
   }
   return result;
 }
 
-Matrix Matrix::InverseMatrix() const {
-  double determinant = Determinant();
-  if (fabs(determinant) < kEpsilon) {
-    throw std::invalid_argument("The matrix determinant is 0.");
-  }
-  Matrix result(rows_, cols_);
-  if (rows_ == 1) {
-    result.matrix_[0][0] = 1 / matrix_[0][0];
-  } else {
-    result = CalcComplements();
-    result = result.Transpose();
-    for (int i = 0; i < result.rows_; ++i) {
-      for (int j = 0; j < result.cols_; ++j) {
-        result.matrix_[i][j] /= determinant;
-      }
-    }
+template <class T>
+BasicLuFactor<T> BasicMatrix<T>::Lu() const {
+  if (!SquareMatrix()) {
+    throw std::invalid_argument("The matrix is not square.");
   }
+  BasicLuFactor<T> result;
+  result.Factorize(*this);
   return result;
 }
 
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::InverseMatrix() const {
+  BasicLuFactor<T> lu = Lu();
+  if (lu.IsSingular()) {
+    throw std::invalid_argument("The matrix determinant is 0.");
+  }
+  return lu.Inverse();
+}
+
 // --------------------- OPERATORS ---------------------
-Matrix& Matrix::operator=(const Matrix& other) {
-  Matrix copy(other);
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const BasicMatrix& other) {
+  BasicMatrix copy(other);
   SwapMatrix(copy);
   return *this;
 }
 
-Matrix& Matrix::operator=(Matrix&& other) {
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix&& other) {
   SwapMatrix(other);
   return *this;
 }
 
-bool Matrix::operator==(const Matrix& other) const noexcept {
+template <class T>
+bool BasicMatrix<T>::operator==(const BasicMatrix& other) const noexcept {
   bool output = false;
   if (EqualSize(other)) {
     output = EqualNumbers(other);
@@ -188,166 +277,202 @@ bool Matrix::operator==(const Matrix& other) const noexcept {
   return output;
 }
 
-bool Matrix::operator!=(const Matrix& other) const noexcept {
+template <class T>
+bool BasicMatrix<T>::operator!=(const BasicMatrix& other) const noexcept {
   return !(*this == other);
 }
 
-Matrix Matrix::operator+(const Matrix& second) const {
-  Matrix result = *this;
-  result += second;
-  return result;
-}
-
-Matrix Matrix::operator-(const Matrix& second) const {
-  Matrix result = *this;
-  result -= second;
-  return result;
-}
-
-Matrix Matrix::operator*(int number) const {
-  Matrix result = *this;
-  result *= number;
-  return result;
-}
-
-Matrix Matrix::operator*(const Matrix& other) const {
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::operator*(const BasicMatrix& other) const {
   if (!EqualForMult(other)) {
     throw std::invalid_argument(
         "The number of columns of the first matrix is not equal to the number "
         "of rows of the second matrix.");
   }
-  Matrix result(rows_, other.cols_);
-  for (int i = 0; i < rows_; ++i) {
-    for (int j = 0; j < other.cols_; ++j) {
-      for (int k = 0; k < cols_; ++k) {
-        result.matrix_[i][j] += matrix_[i][k] * other.matrix_[k][j];
-      }
-    }
-  }
+  BasicMatrix result(rows_, other.cols_);
+  gemm::Multiply(rows_, other.cols_, cols_, T(1), matrix_, cols_,
+                 other.matrix_, other.cols_, result.matrix_, result.cols_);
   return result;
 }
 
-const Matrix operator*(int number, const Matrix& matrix) {
-  return matrix * number;
-}
-
-const Matrix& Matrix::operator+=(const Matrix& other) {
+template <class T>
+const BasicMatrix<T>& BasicMatrix<T>::operator+=(const BasicMatrix& other) {
   if (!EqualSize(other)) {
     throw std::invalid_argument("Different matrix dimensions.");
   }
-  for (int i = 0; i < rows_; ++i) {
-    for (int j = 0; j < cols_; ++j) {
-      matrix_[i][j] = matrix_[i][j] + other.matrix_[i][j];
-    }
-  }
+  simd::Add(matrix_, other.matrix_, Size());
   return *this;
 }
 
-const Matrix& Matrix::operator-=(const Matrix& other) {
+template <class T>
+const BasicMatrix<T>& BasicMatrix<T>::operator-=(const BasicMatrix& other) {
   if (!EqualSize(other)) {
     throw std::invalid_argument("Different matrix dimensions.");
   }
-  for (int i = 0; i < rows_; ++i) {
-    for (int j = 0; j < cols_; ++j) {
-      matrix_[i][j] = matrix_[i][j] - other.matrix_[i][j];
-    }
-  }
+  simd::Sub(matrix_, other.matrix_, Size());
   return *this;
 }
 
-const Matrix& Matrix::operator*=(int number) noexcept {
-  for (int i = 0; i < rows_; ++i) {
-    for (int j = 0; j < cols_; ++j) {
-      matrix_[i][j] = matrix_[i][j] * number;
-    }
-  }
+template <class T>
+const BasicMatrix<T>& BasicMatrix<T>::operator*=(int number) noexcept {
+  simd::Scale(matrix_, number, Size());
   return *this;
 }
 
-const Matrix& Matrix::operator*=(const Matrix& other) {
+template <class T>
+const BasicMatrix<T>& BasicMatrix<T>::operator*=(const BasicMatrix& other) {
   *this = *this * other;
   return *this;
 }
 
-double& Matrix::operator()(int i, int j) {
+template <class T>
+T& BasicMatrix<T>::operator()(int i, int j) {
   if (i >= rows_ && j >= cols_) {
     throw std::out_of_range("Index out of range.");
   }
-  return matrix_[i][j];
+  return matrix_[i * cols_ + j];
 }
 
-const double& Matrix::operator()(int i, int j) const {
+template <class T>
+const T& BasicMatrix<T>::operator()(int i, int j) const {
   if (i >= rows_ && j >= cols_) {
     throw std::out_of_range("Index out of range.");
   }
-  return matrix_[i][j];
+  return matrix_[i * cols_ + j];
+}
+
+template <class T>
+T* BasicMatrix<T>::Data() noexcept { return matrix_; }
+
+template <class T>
+const T* BasicMatrix<T>::Data() const noexcept { return matrix_; }
+
+template <class T>
+std::pmr::memory_resource* BasicMatrix<T>::GetResource() const noexcept {
+  return resource_;
 }
 
 // --------------------- UTILS ---------------------
 
-void Matrix::InitializeMatrix() noexcept {
-  for (int i = 0; i < rows_; ++i) {
-    for (int j = 0; j < cols_; ++j) {
-      matrix_[i][j] = 0;
+// Takes storage for size elements of an empty matrix: the inline buffer when
+// it is large enough, the current memory resource otherwise.
+template <class T>
+void BasicMatrix<T>::Allocate(int size) {
+  if (size > 0 && size <= kInlineSize) {
+    matrix_ = inline_;
+    capacity_ = kInlineSize;
+  } else if (size > 0) {
+    resource_ = memory::GetResource();
+    matrix_ = static_cast<T*>(
+        resource_->allocate(size * sizeof(T), memory::kAlignment));
+    capacity_ = size;
+  }
+}
+
+// Also serves BasicMatrixView::Transpose, which reads through its stride.
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::Transposed(const T* data, int rows, int cols,
+                                          int stride) {
+  BasicMatrix result(cols, rows, Uninitialized());
+  for (int ib = 0; ib < rows; ib += kTransposeTile) {
+    const int i_end = std::min(ib + kTransposeTile, rows);
+    for (int jb = 0; jb < cols; jb += kTransposeTile) {
+      const int j_end = std::min(jb + kTransposeTile, cols);
+      for (int i = ib; i < i_end; ++i) {
+        const T* src = data + i * stride;
+        for (int j = jb; j < j_end; ++j) {
+          result.matrix_[j * rows + i] = src[j];
+        }
+      }
     }
   }
+  return result;
+}
+
+template <class T>
+bool BasicMatrix<T>::IsInline() const noexcept { return matrix_ == inline_; }
+
+template <class T>
+void BasicMatrix<T>::InitializeMatrix() noexcept {
+  std::fill(matrix_, matrix_ + Size(), T());
 }
 
-void Matrix::SwapMatrix(Matrix& other) {
+template <class T>
+int BasicMatrix<T>::Size() const noexcept { return rows_ * cols_; }
+
+template <class T>
+T* BasicMatrix<T>::Row(int i) noexcept { return matrix_ + i * cols_; }
+
+template <class T>
+const T* BasicMatrix<T>::Row(int i) const noexcept {
+  return matrix_ + i * cols_;
+}
+
+// An inline buffer cannot change owners, so its elements are exchanged and
+// the pointers are set up again to refer to the right buffers. Only the used
+// part of an inline buffer is copied, as the rest is left uninitialized.
+template <class T>
+void BasicMatrix<T>::SwapMatrix(BasicMatrix& other) {
+  const bool inline_this = IsInline();
+  const bool inline_other = other.IsInline();
+  if (inline_this && inline_other) {
+    T elements[kInlineSize];
+    std::copy(inline_, inline_ + Size(), elements);
+    std::copy(other.inline_, other.inline_ + other.Size(), inline_);
+    std::copy(elements, elements + Size(), other.inline_);
+  } else if (inline_this) {
+    std::copy(inline_, inline_ + Size(), other.inline_);
+  } else if (inline_other) {
+    std::copy(other.inline_, other.inline_ + other.Size(), inline_);
+  }
   std::swap(matrix_, other.matrix_);
+  if (inline_this) other.matrix_ = other.inline_;
+  if (inline_other) matrix_ = inline_;
   std::swap(rows_, other.rows_);
   std::swap(cols_, other.cols_);
+  std::swap(resource_, other.resource_);
+  std::swap(capacity_, other.capacity_);
 }
 
-bool Matrix::EqualSize(const Matrix& other) const noexcept {
+template <class T>
+bool BasicMatrix<T>::EqualSize(const BasicMatrix& other) const noexcept {
   return (rows_ == other.rows_ && cols_ == other.cols_);
 }
 
-bool Matrix::SquareMatrix() const noexcept { return (rows_ == cols_); }
+template <class T>
+bool BasicMatrix<T>::SquareMatrix() const noexcept { return (rows_ == cols_); }
 
-bool Matrix::EqualForMult(const Matrix& other) const noexcept {
+template <class T>
+bool BasicMatrix<T>::EqualForMult(const BasicMatrix& other) const noexcept {
   return (cols_ == other.rows_);
 }
 
-bool Matrix::EqualNumbers(const Matrix& other) const noexcept {
-  bool output = true;
-  for (int i = 0; i < rows_ && output; ++i) {
-    for (int j = 0; j < cols_ && output; ++j) {
-      if (fabs(this->matrix_[i][j] - other.matrix_[i][j]) > kEpsilon) {
-        output = false;
-      }
-    }
-  }
-  return output;
+template <class T>
+bool BasicMatrix<T>::EqualNumbers(const BasicMatrix& other) const noexcept {
+  return simd::Equal(matrix_, other.matrix_, Size(),
+                     MatrixTraits<T>::kTolerance);
 }
 
-void Matrix::MatrixMinors(const Matrix& other) const {
-  double minor;
-  if (rows_ == 1) {
-    minor = Determinant();
-    other.matrix_[0][0] = minor;
-  } else {
-    Matrix for_minor(rows_ - 1, cols_ - 1);
-    for (int i = 0; i < rows_; ++i) {
-      for (int j = 0; j < cols_; ++j) {
-        ShiftMatrix(for_minor, i, j);
-        minor = for_minor.Determinant();
-        other.matrix_[i][j] = minor;
-      }
-    }
-  }
-}
+// --------------------- GEMM ---------------------
 
-void Matrix::ShiftMatrix(const Matrix& other, int row_not,
-                         int colum_not) const noexcept {
-  int shift_row = 0;
-  for (int row = 0; row < other.rows_; ++row) {
-    if (row == row_not) shift_row = 1;
-    int shift_column = 0;
-    for (int column = 0; column < other.rows_; ++column) {
-      if (column == colum_not) shift_column = 1;
-      other.matrix_[row][column] =
-          matrix_[row + shift_row][column + shift_column];
-    }
-  }
+template <class T>
+void Gemm(typename BasicMatrix<T>::ValueType alpha, const BasicMatrix<T>& a,
+          bool trans_a, const BasicMatrix<T>& b, bool trans_b,
+          typename BasicMatrix<T>::ValueType beta, BasicMatrix<T>& c) {
+  Gemm(alpha, BasicMatrixView<const T>(a), trans_a,
+       BasicMatrixView<const T>(b), trans_b, beta, BasicMatrixView<T>(c));
 }
+
+template void Gemm<float>(float, const FloatMatrix&, bool,
+                          const FloatMatrix&, bool, float, FloatMatrix&);
+template void Gemm<double>(double, const Matrix&, bool, const Matrix&, bool,
+                           double, Matrix&);
+template void Gemm<std::complex<double>>(std::complex<double>,
+                                         const ComplexMatrix&, bool,
+                                         const ComplexMatrix&, bool,
+                                         std::complex<double>,
+                                         ComplexMatrix&);
+
+template class BasicMatrix<float>;
+template class BasicMatrix<double>;
+template class BasicMatrix<std::complex<double>>;
@@ -2,68 +2,385 @@
 #define _MATRIX_OOP_LIB__MATRIX_OOP_H_
 
 #include <cmath>
+#include <complex>
 #include <iostream>
+#include <memory_resource>
+#include <utility>
+#include <vector>
 
-const double kEpsilon = 1.0E-8;
+#include "matrix_expr.h"
 
-class Matrix {
+constexpr double kEpsilon = 1.0E-8;
+
+// Per element type constants. Tolerance is the threshold used by comparisons
+// and singularity checks; float gets a looser one than its 1e-7 precision.
+template <class T>
+struct MatrixTraits {
+  using Real = T;
+  static constexpr Real kTolerance = kEpsilon;
+};
+
+template <>
+struct MatrixTraits<float> {
+  using Real = float;
+  static constexpr Real kTolerance = 1.0E-5f;
+};
+
+template <class R>
+struct MatrixTraits<std::complex<R>> {
+  using Real = R;
+  static constexpr Real kTolerance = MatrixTraits<R>::kTolerance;
+};
+
+template <class T>
+class BasicLuFactor;
+template <class T>
+class BasicMatrixView;
+
+// Dense row-major matrix of T. Instantiated for float, double and
+// std::complex<double>; Transpose() of a complex matrix does not conjugate.
+// Matrices of up to kInlineSize elements keep them inside the object and
+// never allocate; moving one copies the elements, so Data() of a small matrix
+// changes on move. Larger storage comes from memory::GetResource() of the
+// constructing thread, so every matrix built inside a memory::ScopedResource,
+// temporaries included, allocates from the scoped arena or pool instead of
+// the global heap.
+template <class T>
+class BasicMatrix {
  public:
-  Matrix() noexcept;             // Default constructor
-  Matrix(int rows_, int cols_);  // My constructor
-  ~Matrix();                     // Destructor
+  using ValueType = T;
+  using Real = typename MatrixTraits<T>::Real;
+
+  // Largest number of elements stored inline, without a heap allocation.
+  static const int kInlineSize = 16;
+
+  BasicMatrix() noexcept;           // Default constructor
+  BasicMatrix(int rows, int cols);  // My constructor
+  ~BasicMatrix();                   // Destructor
 
-  Matrix(const Matrix &other);  // Copy
-  Matrix(Matrix &&other);       // Move
+  BasicMatrix(const BasicMatrix &other);  // Copy
+  BasicMatrix(BasicMatrix &&other);       // Move
+
+  // Evaluation of a lazy +, - or scalar * expression in a single pass
+  template <class E, class = expr::EnableIfExpression<E>>
+  BasicMatrix(const E &expression);
 
   int GetRows() const noexcept;
   int GetCols() const noexcept;
   void SetRows(const int rows);
   void SetCols(const int cols);
+  // Makes room for rows rows of the current width, so that SetRows() up to
+  // that many rows grows the matrix in place. Shape and elements are kept.
+  void ReserveRows(int rows);
+
+  bool EqMatrix(const BasicMatrix &other) const;
+  void SumMatrix(const BasicMatrix &other);
+  void SubMatrix(const BasicMatrix &other);
+  void MulNumber(const T num);
+  void MulMatrix(const BasicMatrix &other);
+  BasicMatrix Transpose() const;
+  void TransposeInPlace();
+  // Cofactor matrix C, with A * C^T = det(A) * I. The cofactor of a 1 x 1
+  // matrix is the determinant of the empty minor, so the result is [1]
+  // whatever the element.
+  BasicMatrix CalcComplements() const;
+  T Determinant() const;
+  BasicMatrix InverseMatrix() const;
+  BasicLuFactor<T> Lu() const;
+
+  bool operator==(const BasicMatrix &other) const noexcept;
+  bool operator!=(const BasicMatrix &other) const noexcept;
+  BasicMatrix &operator=(const BasicMatrix &other);
+  BasicMatrix &operator=(BasicMatrix &&other);
+  template <class E, class = expr::EnableIfExpression<E>>
+  BasicMatrix &operator=(const E &expression);
 
-  bool EqMatrix(const Matrix &other) const;
-  void SumMatrix(const Matrix &other);
-  void SubMatrix(const Matrix &other);
-  void MulNumber(const double num);
-  void MulMatrix(const Matrix &other);
-  Matrix Transpose() const;
-  Matrix CalcComplements() const;
-  double Determinant() const;
-  Matrix InverseMatrix() const;
-
-  bool operator==(const Matrix &other) const noexcept;
-  bool operator!=(const Matrix &other) const noexcept;
-  Matrix &operator=(const Matrix &other);
-  Matrix &operator=(Matrix &&other);
-
-  Matrix operator+(const Matrix &second) const;
-  Matrix operator-(const Matrix &second) const;
-  Matrix operator*(int number) const;
-  Matrix operator*(const Matrix &other) const;
-  friend const Matrix operator*(int number, const Matrix &matrix);
-
-  const Matrix &operator+=(const Matrix &other);
-  const Matrix &operator-=(const Matrix &other);
-  const Matrix &operator*=(const Matrix &other);
-  const Matrix &operator*=(int number) noexcept;
-
-  double &operator()(int i, int j);
-  double const &operator()(int i, int j) const;
+  BasicMatrix operator*(const BasicMatrix &other) const;
+
+  const BasicMatrix &operator+=(const BasicMatrix &other);
+  const BasicMatrix &operator-=(const BasicMatrix &other);
+  template <class E, class = expr::EnableIfExpression<E>>
+  const BasicMatrix &operator+=(const E &expression);
+  template <class E, class = expr::EnableIfExpression<E>>
+  const BasicMatrix &operator-=(const E &expression);
+  const BasicMatrix &operator*=(const BasicMatrix &other);
+  const BasicMatrix &operator*=(int number) noexcept;
+
+  T &operator()(int i, int j);
+  T const &operator()(int i, int j) const;
+
+  T *Data() noexcept;
+  const T *Data() const noexcept;
+  // Resource the storage was allocated from and will be returned to, or
+  // nullptr when the elements are inline or the matrix is empty.
+  std::pmr::memory_resource *GetResource() const noexcept;
 
  private:
+  template <class>
+  friend class BasicLuFactor;
+  template <class>
+  friend class BasicMatrixView;
+
   int rows_, cols_;
-  double **matrix_;
+  // Single row-major buffer; the leading dimension equals cols_, so element
+  // (i, j) lives at matrix_[i * cols_ + j].
+  T *matrix_;
+  std::pmr::memory_resource *resource_;
+  // Number of elements allocated for matrix_, at least rows_ * cols_.
+  int capacity_;
+  // Storage of small matrices; matrix_ points here when IsInline(). Not
+  // initialized beyond the elements in use.
+  T inline_[kInlineSize];
+
+  struct Uninitialized {};
+  BasicMatrix(int rows, int cols, Uninitialized);
 
+  // Transpose of the rows x cols elements at data with row stride stride.
+  static BasicMatrix Transposed(const T *data, int rows, int cols,
+                                int stride);
+  void Allocate(int size);
+  bool IsInline() const noexcept;
   void InitializeMatrix() noexcept;
-  bool EqualSize(const Matrix &other) const noexcept;
-  bool EqualNumbers(const Matrix &other) const noexcept;
-  bool EqualForMult(const Matrix &other) const noexcept;
+  int Size() const noexcept;
+  T *Row(int i) noexcept;
+  const T *Row(int i) const noexcept;
+  bool EqualSize(const BasicMatrix &other) const noexcept;
+  bool EqualNumbers(const BasicMatrix &other) const noexcept;
+  bool EqualForMult(const BasicMatrix &other) const noexcept;
   bool SquareMatrix() const noexcept;
-  void SwapMatrix(Matrix &other);
-  void MatrixMinors(const Matrix &other) const;
-  void ShiftMatrix(const Matrix &other, int row_not,
-                   int colum_not) const noexcept;
+  void SwapMatrix(BasicMatrix &other);
 };
 
-#endif  // _MATRIX_OOP_LIB__MATRIX_OOP_H_
+// LU factorization with partial pivoting, P * A = L * U, as produced by
+// BasicMatrix::Lu(). L (unit diagonal, not stored) and U are packed into a
+// single matrix: L below the diagonal, U on and above it. GetPivots()[k] is
+// the row that was swapped with row k at step k of the elimination.
+template <class T>
+class BasicLuFactor {
+ public:
+  BasicLuFactor() noexcept;
+
+  const BasicMatrix<T> &GetLu() const noexcept;
+  const std::vector<int> &GetPivots() const noexcept;
+  int GetSize() const noexcept;
+  // True when the smallest pivot is at most MatrixTraits<T>::kTolerance times
+  // the largest one, so that A and any nonzero multiple of A are judged the
+  // same way. The rule behind Solve(), BasicMatrix::InverseMatrix() and
+  // BasicMatrix::CalcComplements(). An empty factorization is not singular.
+  bool IsSingular() const noexcept;
+  T Determinant() const noexcept;
+  BasicMatrix<T> Inverse() const;
+  // Solution X of A * X = rhs for any number of right-hand side columns. The
+  // factorization is reused, so repeated solves cost O(n^2) per column.
+  // Throws std::invalid_argument when IsSingular(). An empty system has the
+  // empty 0 x rhs.cols solution.
+  BasicMatrix<T> Solve(const BasicMatrix<T> &rhs) const;
+
+ private:
+  template <class>
+  friend class BasicMatrix;
+
+  using Real = typename MatrixTraits<T>::Real;
+
+  BasicMatrix<T> lu_;
+  std::vector<int> pivots_;
+  int sign_;
 
-const Matrix operator*(int number, const Matrix &matrix);
\ No newline at end of file
+  void Factorize(const BasicMatrix<T> &matrix);
+  void SolveInPlace(BasicMatrix<T> &rhs) const;
+
+  static BasicMatrix<T> SingularComplements(const BasicMatrix<T> &matrix);
+};
+
+// BLAS-style C = alpha * op(A) * op(B) + beta * C, where op(X) is X or its
+// transpose as selected by trans_a and trans_b. The result accumulates into
+// the existing buffer of C, which must already have the shape of the product,
+// and the kernel packs operands into per-thread buffers kept between calls
+// and grown from std::pmr::get_default_resource(), so once those have grown
+// a loop of Gemm calls does not allocate. With beta == 0 the previous
+// contents of C are ignored. C may be the same matrix as A or B, in which
+// case that operand is copied first, from memory::GetResource().
+// matrix_view.h overloads it for blocks of larger matrices.
+template <class T>
+void Gemm(typename BasicMatrix<T>::ValueType alpha, const BasicMatrix<T> &a,
+          bool trans_a, const BasicMatrix<T> &b, bool trans_b,
+          typename BasicMatrix<T>::ValueType beta, BasicMatrix<T> &c);
+
+// Solution X of A * X = B through the pivoted LU of A, without forming the
+// inverse. For several solves with the same A, keep A.Lu() and call Solve
+// on it.
+template <class T>
+BasicMatrix<T> Solve(const BasicMatrix<T> &a, const BasicMatrix<T> &b);
+
+using Matrix = BasicMatrix<double>;
+using FloatMatrix = BasicMatrix<float>;
+using ComplexMatrix = BasicMatrix<std::complex<double>>;
+using LuFactor = BasicLuFactor<double>;
+
+extern template class BasicMatrix<float>;
+extern template class BasicMatrix<double>;
+extern template class BasicMatrix<std::complex<double>>;
+extern template class BasicLuFactor<float>;
+extern template class BasicLuFactor<double>;
+extern template class BasicLuFactor<std::complex<double>>;
+
+namespace expr {
+
+template <class T>
+struct Operand<BasicMatrix<T>, void> {
+  static const bool kValid = true;
+  using Type = Leaf<T>;
+  static Leaf<T> Make(const BasicMatrix<T> &matrix) noexcept {
+    return Leaf<T>(matrix.Data(), matrix.GetRows(), matrix.GetCols(),
+                   matrix.GetCols());
+  }
+};
+
+}  // namespace expr
+
+// Overloads for expiring matrix operands. The result is computed in the
+// buffer of the operand that is about to die and handed on, so f(A) + g(B)
+// allocates nothing beyond the matrices f and g returned. The other operand
+// may be a matrix or an expression.
+template <class T, class R, class = expr::EnableIfOperand<R>>
+BasicMatrix<T> operator+(BasicMatrix<T> &&left, const R &right) {
+  left += right;
+  return std::move(left);
+}
+
+template <class L, class T, class = expr::EnableIfOperand<L>>
+BasicMatrix<T> operator+(const L &left, BasicMatrix<T> &&right) {
+  right += left;
+  return std::move(right);
+}
+
+template <class T>
+BasicMatrix<T> operator+(BasicMatrix<T> &&left, BasicMatrix<T> &&right) {
+  left += right;
+  return std::move(left);
+}
+
+template <class T, class R, class = expr::EnableIfOperand<R>>
+BasicMatrix<T> operator-(BasicMatrix<T> &&left, const R &right) {
+  left -= right;
+  return std::move(left);
+}
+
+template <class L, class T, class = expr::EnableIfOperand<L>>
+BasicMatrix<T> operator-(const L &left, BasicMatrix<T> &&right) {
+  static_assert(std::is_same<typename expr::Operand<L>::Type::ValueType,
+                             T>::value,
+                "Operands of different element types.");
+  const typename expr::Operand<L>::Type operand =
+      expr::Operand<L>::Make(left);
+  if (operand.GetRows() != right.GetRows() ||
+      operand.GetCols() != right.GetCols()) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  T *data = right.Data();
+  const int rows = right.GetRows();
+  const int cols = right.GetCols();
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      data[i * cols + j] = operand.At(i, j) - data[i * cols + j];
+    }
+  }
+  return std::move(right);
+}
+
+template <class T>
+BasicMatrix<T> operator-(BasicMatrix<T> &&left, BasicMatrix<T> &&right) {
+  left -= right;
+  return std::move(left);
+}
+
+template <class T>
+BasicMatrix<T> operator*(BasicMatrix<T> &&matrix, int number) {
+  matrix *= number;
+  return std::move(matrix);
+}
+
+template <class T>
+BasicMatrix<T> operator*(int number, BasicMatrix<T> &&matrix) {
+  matrix *= number;
+  return std::move(matrix);
+}
+
+// Matrix product with an unevaluated operand on the left.
+template <class E, class = expr::EnableIfExpression<E>>
+BasicMatrix<typename E::ValueType> operator*(
+    const E &expression, const BasicMatrix<typename E::ValueType> &other) {
+  return BasicMatrix<typename E::ValueType>(expression) * other;
+}
+
+template <class T>
+template <class E, class>
+BasicMatrix<T>::BasicMatrix(const E &expression)
+    : BasicMatrix(expression.GetRows(), expression.GetCols(),
+                  Uninitialized()) {
+  static_assert(std::is_same<typename E::ValueType, T>::value,
+                "Expression and matrix element types differ.");
+  for (int i = 0; i < rows_; ++i) {
+    T *row = Row(i);
+    for (int j = 0; j < cols_; ++j) {
+      row[j] = expression.At(i, j);
+    }
+  }
+}
+
+// Every element of an expression depends only on the same element of its
+// operands, so evaluating into a same-shaped operand is safe.
+template <class T>
+template <class E, class>
+BasicMatrix<T> &BasicMatrix<T>::operator=(const E &expression) {
+  static_assert(std::is_same<typename E::ValueType, T>::value,
+                "Expression and matrix element types differ.");
+  if (rows_ == expression.GetRows() && cols_ == expression.GetCols()) {
+    for (int i = 0; i < rows_; ++i) {
+      T *row = Row(i);
+      for (int j = 0; j < cols_; ++j) {
+        row[j] = expression.At(i, j);
+      }
+    }
+  } else {
+    BasicMatrix result(expression);
+    SwapMatrix(result);
+  }
+  return *this;
+}
+
+template <class T>
+template <class E, class>
+const BasicMatrix<T> &BasicMatrix<T>::operator+=(const E &expression) {
+  static_assert(std::is_same<typename E::ValueType, T>::value,
+                "Expression and matrix element types differ.");
+  if (rows_ != expression.GetRows() || cols_ != expression.GetCols()) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  for (int i = 0; i < rows_; ++i) {
+    T *row = Row(i);
+    for (int j = 0; j < cols_; ++j) {
+      row[j] += expression.At(i, j);
+    }
+  }
+  return *this;
+}
+
+template <class T>
+template <class E, class>
+const BasicMatrix<T> &BasicMatrix<T>::operator-=(const E &expression) {
+  static_assert(std::is_same<typename E::ValueType, T>::value,
+                "Expression and matrix element types differ.");
+  if (rows_ != expression.GetRows() || cols_ != expression.GetCols()) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  for (int i = 0; i < rows_; ++i) {
+    T *row = Row(i);
+    for (int j = 0; j < cols_; ++j) {
+      row[j] -= expression.At(i, j);
+    }
+  }
+  return *this;
+}
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_OOP_H_
@@ -0,0 +1,474 @@
+#include "matrix_qr.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "matrix_gemm.h"
+
+namespace {
+
+// Columns factored together and applied to the trailing matrix as one
+// compact WY block.
+const int kPanel = 64;
+// Panels are split recursively down to this many columns, which are then
+// factored one reflector at a time.
+const int kLeaf = 8;
+
+template <class R>
+R Conjugate(const R& x) {
+  return x;
+}
+
+template <class R>
+std::complex<R> Conjugate(const std::complex<R>& x) {
+  return std::conj(x);
+}
+
+// The GEMM kernel transposes but does not conjugate, so V^H * C is computed
+// as conj(V^T * conj(C)), conjugating C in place and back. No-op for real
+// types.
+template <class R>
+void ConjugateBlock(int, int, R*, int) {}
+
+template <class R>
+void ConjugateBlock(int rows, int cols, std::complex<R>* a, int lda) {
+  for (int i = 0; i < rows; ++i) {
+    std::complex<R>* row = a + i * lda;
+    for (int j = 0; j < cols; ++j) {
+      row[j] = std::conj(row[j]);
+    }
+  }
+}
+
+// w[k x q] = V^H * C, for the k reflectors stored unit lower trapezoidal in
+// the rows x k block v and a rows x q block c. The triangle on top is done
+// by row axpys, the rectangle below by the GEMM kernel.
+template <class T>
+void ReflectorProduct(int rows, int k, const T* v, int ldv, T* c, int ldc,
+                      int q, T* w) {
+  std::fill(w, w + k * q, T());
+  if (rows > k) {
+    T* c_bottom = c + k * ldc;
+    ConjugateBlock(rows - k, q, c_bottom, ldc);
+    gemm::Multiply(gemm::Op::kTrans, gemm::Op::kNoTrans, k, q, rows - k, T(1),
+                   v + k * ldv, ldv, c_bottom, ldc, w, q);
+    ConjugateBlock(rows - k, q, c_bottom, ldc);
+    ConjugateBlock(k, q, w, q);
+  }
+  for (int r = 0; r < k; ++r) {
+    const T* c_row = c + r * ldc;
+    for (int p = 0; p <= r; ++p) {
+      const T coefficient = (p == r) ? T(1) : Conjugate(v[r * ldv + p]);
+      T* w_row = w + p * q;
+      for (int j = 0; j < q; ++j) {
+        w_row[j] += coefficient * c_row[j];
+      }
+    }
+  }
+}
+
+// C := (I - V * op(T) * V^H) * C, with op(T) = T^H when adjoint, which
+// applies Q^H, and T otherwise, which applies Q.
+template <class T>
+void ApplyBlock(bool adjoint, int rows, int k, const T* v, int ldv,
+                const T* t, int ldt, T* c, int ldc, int q) {
+  if (k == 0 || q == 0) return;
+  std::vector<T> w(static_cast<size_t>(k) * q);
+  ReflectorProduct(rows, k, v, ldv, c, ldc, q, w.data());
+  // W := op(T) * W in place. T^H is lower triangular, so its rows are
+  // formed from the bottom up; T from the top down.
+  for (int s = 0; s < k; ++s) {
+    const int i = adjoint ? k - 1 - s : s;
+    T* w_i = w.data() + i * q;
+    const T diagonal = adjoint ? Conjugate(t[i * ldt + i]) : t[i * ldt + i];
+    for (int j = 0; j < q; ++j) {
+      w_i[j] *= diagonal;
+    }
+    const int p_begin = adjoint ? 0 : i + 1;
+    const int p_end = adjoint ? i : k;
+    for (int p = p_begin; p < p_end; ++p) {
+      const T coefficient =
+          adjoint ? Conjugate(t[p * ldt + i]) : t[i * ldt + p];
+      const T* w_p = w.data() + p * q;
+      for (int j = 0; j < q; ++j) {
+        w_i[j] += coefficient * w_p[j];
+      }
+    }
+  }
+  // C -= V * W.
+  if (rows > k) {
+    gemm::Multiply(rows - k, q, k, T(-1), v + k * ldv, ldv, w.data(), q,
+                   c + k * ldc, ldc);
+  }
+  for (int r = 0; r < k; ++r) {
+    T* c_row = c + r * ldc;
+    for (int p = 0; p <= r; ++p) {
+      const T coefficient = (p == r) ? T(1) : v[r * ldv + p];
+      const T* w_p = w.data() + p * q;
+      for (int j = 0; j < q; ++j) {
+        c_row[j] -= coefficient * w_p[j];
+      }
+    }
+  }
+}
+
+// 2-norm of count elements of x with the given stride, summed as LAPACK's
+// xLASSQ does: squares are taken relative to the largest magnitude seen so
+// far, so entries near the overflow or underflow threshold keep full
+// precision. Real and imaginary parts count as separate entries.
+template <class T>
+typename MatrixTraits<T>::Real ScaledNorm(int count, const T* x, int stride) {
+  using Real = typename MatrixTraits<T>::Real;
+  Real scale = 0;
+  Real sum = 1;
+  auto add = [&](Real value) {
+    value = std::fabs(value);
+    if (value == 0) return;
+    if (scale < value) {
+      sum = 1 + sum * (scale / value) * (scale / value);
+      scale = value;
+    } else {
+      sum += (value / scale) * (value / scale);
+    }
+  };
+  for (int i = 0; i < count; ++i) {
+    add(std::real(x[i * stride]));
+    add(std::imag(x[i * stride]));
+  }
+  return scale * std::sqrt(sum);
+}
+
+// 2-norm of the same elements from their plain sum of squares, which is
+// exact enough unless it left the range where no square under- or
+// overflows. Only then is the column summed again through ScaledNorm.
+template <class T>
+typename MatrixTraits<T>::Real TailNorm(typename MatrixTraits<T>::Real squares,
+                                        int count, const T* x, int stride) {
+  using Real = typename MatrixTraits<T>::Real;
+  const Real kSafeMin =
+      std::numeric_limits<Real>::min() / std::numeric_limits<Real>::epsilon();
+  const Real kSafeMax = std::numeric_limits<Real>::max();
+  if (squares >= kSafeMin && squares <= kSafeMax) {
+    return std::sqrt(squares);
+  }
+  return ScaledNorm(count, x, stride);
+}
+
+// Unblocked factorization of a rows x cols panel, rows >= cols: one
+// reflector per column, H = I - tau * v * v^H with v_0 = 1, chosen so that
+// H^H maps the column onto beta * e_1 with a real beta, then applied to the
+// remaining columns. A tall panel does not fit in cache, so each column
+// costs two passes over it: one that scales v and forms w = v^H * A, which
+// stays on the scale of A since |v_i| <= 1, and one that updates the
+// columns and sums the squares of the next tail, which TailNorm redoes with
+// scaling only when they leave the safe range. tau goes to the diagonal of
+// T, and the rest of T follows from the Gram matrix G = V^H * V, taken in
+// one more pass, by the forward recurrence
+// T(0:i, i) = -tau_i * T(0:i, 0:i) * G(0:i, i).
+template <class T>
+void FactorLeaf(int rows, int cols, T* a, int lda, T* t, int ldt) {
+  using Real = typename MatrixTraits<T>::Real;
+  std::vector<T> w(static_cast<size_t>(cols) * cols);
+  Real tail_norm = 0;
+  for (int i = 1; i < rows; ++i) {
+    tail_norm += std::norm(a[i * lda]);
+  }
+  for (int j = 0; j < cols; ++j) {
+    T* head = a + j * lda + j;
+    const int width = cols - j - 1;
+    const T alpha = *head;
+    const Real tail = TailNorm(tail_norm, rows - j - 1, head + lda, lda);
+    T tau = T();
+    T scale = T(1);
+    if (tail != 0 || std::imag(alpha) != 0) {
+      const Real beta =
+          -std::copysign(std::hypot(std::abs(alpha), tail), std::real(alpha));
+      tau = (beta - alpha) / beta;
+      scale = T(1) / (alpha - beta);
+      *head = beta;
+    }
+    t[j * ldt + j] = tau;
+    // Columns j + 1.. of the panel get H^H = I - conj(tau) * v * v^H.
+    std::fill(w.begin(), w.begin() + width, T());
+    if (tau != T()) {
+      for (int i = j + 1; i < rows; ++i) {
+        T* row = a + i * lda;
+        const T v_i = row[j] * scale;
+        row[j] = v_i;
+        const T v_conjugate = Conjugate(v_i);
+        for (int c = 0; c < width; ++c) {
+          w[c] += v_conjugate * row[j + 1 + c];
+        }
+      }
+      const T factor = Conjugate(tau);
+      for (int c = 0; c < width; ++c) {
+        w[c] = factor * (head[1 + c] + w[c]);
+        head[1 + c] -= w[c];
+      }
+    }
+    tail_norm = 0;
+    for (int i = j + 1; i < rows; ++i) {
+      T* row = a + i * lda;
+      const T v_i = row[j];
+      for (int c = 0; c < width; ++c) {
+        row[j + 1 + c] -= v_i * w[c];
+      }
+      if (width > 0 && i > j + 1) tail_norm += std::norm(row[j + 1]);
+    }
+  }
+  // G(p, i), p < i, in w[p * cols + i]. Column p of V is zero above row p
+  // and one at it.
+  std::fill(w.begin(), w.end(), T());
+  for (int r = 1; r < rows; ++r) {
+    const T* row = a + r * lda;
+    const int end = std::min(r, cols);
+    for (int p = 0; p < end; ++p) {
+      const T v_p = Conjugate(row[p]);
+      T* g_p = w.data() + p * cols;
+      for (int i = p + 1; i < end; ++i) {
+        g_p[i] += v_p * row[i];
+      }
+      if (r < cols) g_p[r] += v_p;
+    }
+  }
+  for (int i = 1; i < cols; ++i) {
+    const T tau = t[i * ldt + i];
+    for (int p = 0; p < i; ++p) {
+      T sum = T();
+      for (int q = p; q < i; ++q) {
+        sum += t[p * ldt + q] * w[q * cols + i];
+      }
+      t[p * ldt + i] = -tau * sum;
+    }
+  }
+}
+
+// Recursive panel factorization: factor the left half, apply its block
+// reflector to the right half through ApplyBlock, factor what remains of the
+// right half, and join the two triangular factors with
+// T12 = -T11 * (V1^H * V2) * T22. Nearly all the work of a tall panel goes
+// through GEMM this way.
+template <class T>
+void FactorPanel(int rows, int cols, T* a, int lda, T* t, int ldt) {
+  if (cols <= kLeaf) {
+    FactorLeaf(rows, cols, a, lda, t, ldt);
+    return;
+  }
+  const int left = cols / 2;
+  const int right = cols - left;
+  FactorPanel(rows, left, a, lda, t, ldt);
+  ApplyBlock(true, rows, left, a, lda, t, ldt, a + left, lda, right);
+  T* a22 = a + left * lda + left;
+  T* t22 = t + left * ldt + left;
+  FactorPanel(rows - left, right, a22, lda, t22, ldt);
+
+  // V1^H * V2 over the rows of V2: its unit upper part picks rows of V1 and
+  // the rectangle below goes through GEMM.
+  T* t12 = t + left;
+  for (int p = 0; p < left; ++p) {
+    std::fill(t12 + p * ldt, t12 + p * ldt + right, T());
+  }
+  const T* v1 = a + left * lda;
+  if (rows - left > right) {
+    T* v2_bottom = a22 + right * lda;
+    ConjugateBlock(rows - left - right, right, v2_bottom, lda);
+    gemm::Multiply(gemm::Op::kTrans, gemm::Op::kNoTrans, left, right,
+                   rows - left - right, T(1), a + (left + right) * lda, lda,
+                   v2_bottom, lda, t12, ldt);
+    ConjugateBlock(rows - left - right, right, v2_bottom, lda);
+    ConjugateBlock(left, right, t12, ldt);
+  }
+  for (int r = 0; r < right; ++r) {
+    const T* v1_row = v1 + r * lda;
+    const T* v2_row = a22 + r * lda;
+    for (int p = 0; p < left; ++p) {
+      const T v1_rp = Conjugate(v1_row[p]);
+      T* y = t12 + p * ldt;
+      y[r] += v1_rp;
+      for (int q = 0; q < r; ++q) {
+        y[q] += v1_rp * v2_row[q];
+      }
+    }
+  }
+  // T12 := -T11 * Y * T22; T11 is applied from the top row down and T22
+  // from the last column back, so both products can run in place.
+  for (int i = 0; i < left; ++i) {
+    T* y_i = t12 + i * ldt;
+    const T t_ii = t[i * ldt + i];
+    for (int j = 0; j < right; ++j) {
+      y_i[j] *= t_ii;
+    }
+    for (int p = i + 1; p < left; ++p) {
+      const T t_ip = t[i * ldt + p];
+      const T* y_p = t12 + p * ldt;
+      for (int j = 0; j < right; ++j) {
+        y_i[j] += t_ip * y_p[j];
+      }
+    }
+  }
+  for (int i = 0; i < left; ++i) {
+    T* y_i = t12 + i * ldt;
+    for (int j = right - 1; j >= 0; --j) {
+      T sum = T();
+      for (int p = 0; p <= j; ++p) {
+        sum += y_i[p] * t22[p * ldt + j];
+      }
+      y_i[j] = -sum;
+    }
+  }
+}
+
+}  // namespace
+
+// --------------------- CREATION ---------------------
+
+template <class T>
+BasicQrFactor<T>::BasicQrFactor() noexcept : qr_(), t_() {}
+
+// Right-looking blocked Householder QR. Each kPanel-wide panel is factored
+// by FactorPanel and its compact WY block, Q_b^H = I - V * T^H * V^H, is
+// applied to the trailing columns with two GEMMs.
+template <class T>
+BasicQrFactor<T>::BasicQrFactor(const BasicMatrix<T>& matrix)
+    : qr_(matrix), t_() {
+  const int m = qr_.GetRows();
+  const int n = qr_.GetCols();
+  const int k = std::min(m, n);
+  t_ = BasicMatrix<T>(std::min(kPanel, k), k);
+  T* a = qr_.Data();
+  T* t = t_.Data();
+  for (int kb = 0; kb < k; kb += kPanel) {
+    const int width = std::min(kPanel, k - kb);
+    T* panel = a + kb * n + kb;
+    FactorPanel(m - kb, width, panel, n, t + kb, k);
+    ApplyBlock(true, m - kb, width, panel, n, t + kb, k, panel + width, n,
+               n - kb - width);
+  }
+}
+
+// --------------------- ACCESSORS ---------------------
+
+template <class T>
+int BasicQrFactor<T>::GetRows() const noexcept {
+  return qr_.GetRows();
+}
+
+template <class T>
+int BasicQrFactor<T>::GetCols() const noexcept {
+  return qr_.GetCols();
+}
+
+template <class T>
+BasicMatrix<T> BasicQrFactor<T>::GetR() const {
+  const int n = qr_.GetCols();
+  const int k = std::min(qr_.GetRows(), n);
+  BasicMatrix<T> result(k, n);
+  for (int i = 0; i < k; ++i) {
+    const T* src = qr_.Data() + i * n;
+    std::copy(src + i, src + n, result.Data() + i * n + i);
+  }
+  return result;
+}
+
+// Q * [I; 0], with the blocks applied last to first: block b only touches
+// rows from kb on, where the columns before kb are still zero.
+template <class T>
+BasicMatrix<T> BasicQrFactor<T>::GetQ() const {
+  const int m = qr_.GetRows();
+  const int n = qr_.GetCols();
+  const int k = std::min(m, n);
+  BasicMatrix<T> result(m, k);
+  T* q = result.Data();
+  for (int i = 0; i < k; ++i) {
+    q[i * k + i] = 1;
+  }
+  const int last = (k == 0) ? 0 : (k - 1) / kPanel * kPanel;
+  for (int kb = last; kb >= 0 && k > 0; kb -= kPanel) {
+    const int width = std::min(kPanel, k - kb);
+    ApplyBlock(false, m - kb, width, qr_.Data() + kb * n + kb, n,
+               t_.Data() + kb, k, q + kb * k + kb, k, k - kb);
+  }
+  return result;
+}
+
+template <class T>
+BasicMatrix<T> BasicQrFactor<T>::ApplyQAdjoint(
+    const BasicMatrix<T>& rhs) const {
+  const int m = qr_.GetRows();
+  const int n = qr_.GetCols();
+  const int k = std::min(m, n);
+  if (rhs.GetRows() != m) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  BasicMatrix<T> result(rhs);
+  const int q = result.GetCols();
+  for (int kb = 0; kb < k; kb += kPanel) {
+    const int width = std::min(kPanel, k - kb);
+    ApplyBlock(true, m - kb, width, qr_.Data() + kb * n + kb, n,
+               t_.Data() + kb, k, result.Data() + kb * q, q, q);
+  }
+  return result;
+}
+
+// --------------------- OPERATIONS ---------------------
+
+// R * X = (Q^H * rhs)[0:cols] by back substitution on whole rows of X.
+template <class T>
+BasicMatrix<T> BasicQrFactor<T>::Solve(const BasicMatrix<T>& rhs) const {
+  const int m = qr_.GetRows();
+  const int n = qr_.GetCols();
+  if (m < n) {
+    throw std::invalid_argument("Number of rows less than columns.");
+  }
+  Real max_diagonal = 0;
+  for (int i = 0; i < n; ++i) {
+    max_diagonal = std::max(max_diagonal, std::abs(qr_.Data()[i * n + i]));
+  }
+  for (int i = 0; i < n; ++i) {
+    if (std::abs(qr_.Data()[i * n + i]) <=
+        MatrixTraits<T>::kTolerance * max_diagonal) {
+      throw std::invalid_argument("The matrix is rank deficient.");
+    }
+  }
+  const BasicMatrix<T> y = ApplyQAdjoint(rhs);
+  const int q = y.GetCols();
+  BasicMatrix<T> result(n, q);
+  std::copy(y.Data(), y.Data() + n * q, result.Data());
+  T* x = result.Data();
+  for (int i = n - 1; i >= 0; --i) {
+    const T* r = qr_.Data() + i * n;
+    T* x_i = x + i * q;
+    for (int p = i + 1; p < n; ++p) {
+      const T r_ip = r[p];
+      if (r_ip == T()) continue;
+      const T* x_p = x + p * q;
+      for (int j = 0; j < q; ++j) {
+        x_i[j] -= r_ip * x_p[j];
+      }
+    }
+    const T inverse = T(1) / r[i];
+    for (int j = 0; j < q; ++j) {
+      x_i[j] *= inverse;
+    }
+  }
+  return result;
+}
+
+template <class T>
+BasicMatrix<T> LeastSquares(const BasicMatrix<T>& a, const BasicMatrix<T>& b) {
+  return BasicQrFactor<T>(a).Solve(b);
+}
+
+template FloatMatrix LeastSquares<float>(const FloatMatrix&,
+                                         const FloatMatrix&);
+template Matrix LeastSquares<double>(const Matrix&, const Matrix&);
+template ComplexMatrix LeastSquares<std::complex<double>>(
+    const ComplexMatrix&, const ComplexMatrix&);
+
+template class BasicQrFactor<float>;
+template class BasicQrFactor<double>;
+template class BasicQrFactor<std::complex<double>>;
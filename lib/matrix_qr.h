@@ -0,0 +1,51 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_QR_H_
+#define _MATRIX_OOP_LIB__MATRIX_QR_H_
+
+#include "matrix_oop.h"
+
+// Householder QR factorization A = Q * R of a rows x cols matrix. R is upper
+// triangular and Q = H_1 * ... * H_k, k = min(rows, cols), is kept as the
+// Householder vectors below the diagonal of R plus the triangular factors
+// of its compact WY form, Q = I - V * T * V^H, one per block of columns.
+// Any shape is accepted; least squares needs rows >= cols. Instantiated for
+// float, double and std::complex<double>.
+template <class T>
+class BasicQrFactor {
+ public:
+  BasicQrFactor() noexcept;
+  explicit BasicQrFactor(const BasicMatrix<T> &matrix);
+
+  int GetRows() const noexcept;
+  int GetCols() const noexcept;
+  // The min(rows, cols) x cols upper triangular R.
+  BasicMatrix<T> GetR() const;
+  // The rows x min(rows, cols) Q with orthonormal columns, A = Q * R.
+  BasicMatrix<T> GetQ() const;
+  // Q^H * rhs for a rhs of GetRows() rows, without forming Q.
+  BasicMatrix<T> ApplyQAdjoint(const BasicMatrix<T> &rhs) const;
+  // X minimizing the 2-norm of A * X - rhs column by column. Throws
+  // std::invalid_argument when rows < cols or A is rank deficient.
+  BasicMatrix<T> Solve(const BasicMatrix<T> &rhs) const;
+
+ private:
+  using Real = typename MatrixTraits<T>::Real;
+
+  // R on and above the diagonal, Householder vectors below it.
+  BasicMatrix<T> qr_;
+  // Upper triangular T of the block of columns [kb, kb + kPanel) in the
+  // columns of the same indices.
+  BasicMatrix<T> t_;
+};
+
+// Least-squares solution of an overdetermined system A * X = B through the
+// QR factorization of A.
+template <class T>
+BasicMatrix<T> LeastSquares(const BasicMatrix<T> &a, const BasicMatrix<T> &b);
+
+using QrFactor = BasicQrFactor<double>;
+
+extern template class BasicQrFactor<float>;
+extern template class BasicQrFactor<double>;
+extern template class BasicQrFactor<std::complex<double>>;
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_QR_H_
@@ -0,0 +1,525 @@
+#include "matrix_simd.h"
+
+#include <atomic>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIX_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace simd {
+
+namespace {
+
+// --------------------- SCALAR ---------------------
+
+template <class T>
+void AddScalar(T* dst, const T* src, int size) noexcept {
+  for (int k = 0; k < size; ++k) {
+    dst[k] = dst[k] + src[k];
+  }
+}
+
+template <class T>
+void SubScalar(T* dst, const T* src, int size) noexcept {
+  for (int k = 0; k < size; ++k) {
+    dst[k] = dst[k] - src[k];
+  }
+}
+
+template <class T>
+void ScaleScalar(T* dst, T factor, int size) noexcept {
+  for (int k = 0; k < size; ++k) {
+    dst[k] = dst[k] * factor;
+  }
+}
+
+template <class T, class R>
+bool EqualScalar(const T* a, const T* b, int size, R epsilon) noexcept {
+  bool output = true;
+  for (int k = 0; k < size && output; ++k) {
+    if (std::abs(a[k] - b[k]) > epsilon) {
+      output = false;
+    }
+  }
+  return output;
+}
+
+#ifdef MATRIX_SIMD_X86
+
+// Each ISA gets a traits struct per element type with the handful of vector
+// operations the kernels need. The traits functions carry the same target
+// attribute as the kernels, so they inline into them.
+
+// --------------------- SSE2 ---------------------
+
+template <class T>
+struct Sse2;
+
+template <>
+struct Sse2<double> {
+  using Vec = __m128d;
+  static const int kWidth = 2;
+  __attribute__((target("sse2"))) static Vec Load(const double* p) {
+    return _mm_loadu_pd(p);
+  }
+  __attribute__((target("sse2"))) static void Store(double* p, Vec v) {
+    _mm_storeu_pd(p, v);
+  }
+  __attribute__((target("sse2"))) static Vec Set(double x) {
+    return _mm_set1_pd(x);
+  }
+  __attribute__((target("sse2"))) static Vec Add(Vec a, Vec b) {
+    return _mm_add_pd(a, b);
+  }
+  __attribute__((target("sse2"))) static Vec Sub(Vec a, Vec b) {
+    return _mm_sub_pd(a, b);
+  }
+  __attribute__((target("sse2"))) static Vec Mul(Vec a, Vec b) {
+    return _mm_mul_pd(a, b);
+  }
+  __attribute__((target("sse2"))) static bool AnyAbsGreater(Vec v, Vec eps) {
+    Vec abs = _mm_andnot_pd(_mm_set1_pd(-0.0), v);
+    return _mm_movemask_pd(_mm_cmpgt_pd(abs, eps)) != 0;
+  }
+};
+
+template <>
+struct Sse2<float> {
+  using Vec = __m128;
+  static const int kWidth = 4;
+  __attribute__((target("sse2"))) static Vec Load(const float* p) {
+    return _mm_loadu_ps(p);
+  }
+  __attribute__((target("sse2"))) static void Store(float* p, Vec v) {
+    _mm_storeu_ps(p, v);
+  }
+  __attribute__((target("sse2"))) static Vec Set(float x) {
+    return _mm_set1_ps(x);
+  }
+  __attribute__((target("sse2"))) static Vec Add(Vec a, Vec b) {
+    return _mm_add_ps(a, b);
+  }
+  __attribute__((target("sse2"))) static Vec Sub(Vec a, Vec b) {
+    return _mm_sub_ps(a, b);
+  }
+  __attribute__((target("sse2"))) static Vec Mul(Vec a, Vec b) {
+    return _mm_mul_ps(a, b);
+  }
+  __attribute__((target("sse2"))) static bool AnyAbsGreater(Vec v, Vec eps) {
+    Vec abs = _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+    return _mm_movemask_ps(_mm_cmpgt_ps(abs, eps)) != 0;
+  }
+};
+
+template <class T>
+__attribute__((target("sse2"))) void AddSse2(T* dst, const T* src,
+                                             int size) noexcept {
+  using V = Sse2<T>;
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    V::Store(dst + k, V::Add(V::Load(dst + k), V::Load(src + k)));
+  }
+  AddScalar(dst + k, src + k, size - k);
+}
+
+template <class T>
+__attribute__((target("sse2"))) void SubSse2(T* dst, const T* src,
+                                             int size) noexcept {
+  using V = Sse2<T>;
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    V::Store(dst + k, V::Sub(V::Load(dst + k), V::Load(src + k)));
+  }
+  SubScalar(dst + k, src + k, size - k);
+}
+
+template <class T>
+__attribute__((target("sse2"))) void ScaleSse2(T* dst, T factor,
+                                               int size) noexcept {
+  using V = Sse2<T>;
+  const typename V::Vec f = V::Set(factor);
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    V::Store(dst + k, V::Mul(V::Load(dst + k), f));
+  }
+  ScaleScalar(dst + k, factor, size - k);
+}
+
+template <class T>
+__attribute__((target("sse2"))) bool EqualSse2(const T* a, const T* b,
+                                               int size, T epsilon) noexcept {
+  using V = Sse2<T>;
+  const typename V::Vec eps = V::Set(epsilon);
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    if (V::AnyAbsGreater(V::Sub(V::Load(a + k), V::Load(b + k)), eps)) {
+      return false;
+    }
+  }
+  return EqualScalar(a + k, b + k, size - k, epsilon);
+}
+
+// --------------------- AVX2 ---------------------
+
+template <class T>
+struct Avx2;
+
+template <>
+struct Avx2<double> {
+  using Vec = __m256d;
+  static const int kWidth = 4;
+  __attribute__((target("avx2"))) static Vec Load(const double* p) {
+    return _mm256_loadu_pd(p);
+  }
+  __attribute__((target("avx2"))) static void Store(double* p, Vec v) {
+    _mm256_storeu_pd(p, v);
+  }
+  __attribute__((target("avx2"))) static Vec Set(double x) {
+    return _mm256_set1_pd(x);
+  }
+  __attribute__((target("avx2"))) static Vec Add(Vec a, Vec b) {
+    return _mm256_add_pd(a, b);
+  }
+  __attribute__((target("avx2"))) static Vec Sub(Vec a, Vec b) {
+    return _mm256_sub_pd(a, b);
+  }
+  __attribute__((target("avx2"))) static Vec Mul(Vec a, Vec b) {
+    return _mm256_mul_pd(a, b);
+  }
+  __attribute__((target("avx2"))) static bool AnyAbsGreater(Vec v, Vec eps) {
+    Vec abs = _mm256_andnot_pd(_mm256_set1_pd(-0.0), v);
+    return _mm256_movemask_pd(_mm256_cmp_pd(abs, eps, _CMP_GT_OQ)) != 0;
+  }
+};
+
+template <>
+struct Avx2<float> {
+  using Vec = __m256;
+  static const int kWidth = 8;
+  __attribute__((target("avx2"))) static Vec Load(const float* p) {
+    return _mm256_loadu_ps(p);
+  }
+  __attribute__((target("avx2"))) static void Store(float* p, Vec v) {
+    _mm256_storeu_ps(p, v);
+  }
+  __attribute__((target("avx2"))) static Vec Set(float x) {
+    return _mm256_set1_ps(x);
+  }
+  __attribute__((target("avx2"))) static Vec Add(Vec a, Vec b) {
+    return _mm256_add_ps(a, b);
+  }
+  __attribute__((target("avx2"))) static Vec Sub(Vec a, Vec b) {
+    return _mm256_sub_ps(a, b);
+  }
+  __attribute__((target("avx2"))) static Vec Mul(Vec a, Vec b) {
+    return _mm256_mul_ps(a, b);
+  }
+  __attribute__((target("avx2"))) static bool AnyAbsGreater(Vec v, Vec eps) {
+    Vec abs = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+    return _mm256_movemask_ps(_mm256_cmp_ps(abs, eps, _CMP_GT_OQ)) != 0;
+  }
+};
+
+template <class T>
+__attribute__((target("avx2"))) void AddAvx2(T* dst, const T* src,
+                                             int size) noexcept {
+  using V = Avx2<T>;
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    V::Store(dst + k, V::Add(V::Load(dst + k), V::Load(src + k)));
+  }
+  AddScalar(dst + k, src + k, size - k);
+}
+
+template <class T>
+__attribute__((target("avx2"))) void SubAvx2(T* dst, const T* src,
+                                             int size) noexcept {
+  using V = Avx2<T>;
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    V::Store(dst + k, V::Sub(V::Load(dst + k), V::Load(src + k)));
+  }
+  SubScalar(dst + k, src + k, size - k);
+}
+
+template <class T>
+__attribute__((target("avx2"))) void ScaleAvx2(T* dst, T factor,
+                                               int size) noexcept {
+  using V = Avx2<T>;
+  const typename V::Vec f = V::Set(factor);
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    V::Store(dst + k, V::Mul(V::Load(dst + k), f));
+  }
+  ScaleScalar(dst + k, factor, size - k);
+}
+
+template <class T>
+__attribute__((target("avx2"))) bool EqualAvx2(const T* a, const T* b,
+                                               int size, T epsilon) noexcept {
+  using V = Avx2<T>;
+  const typename V::Vec eps = V::Set(epsilon);
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    if (V::AnyAbsGreater(V::Sub(V::Load(a + k), V::Load(b + k)), eps)) {
+      return false;
+    }
+  }
+  return EqualScalar(a + k, b + k, size - k, epsilon);
+}
+
+// --------------------- AVX-512 ---------------------
+
+template <class T>
+struct Avx512;
+
+template <>
+struct Avx512<double> {
+  using Vec = __m512d;
+  static const int kWidth = 8;
+  __attribute__((target("avx512f"))) static Vec Load(const double* p) {
+    return _mm512_loadu_pd(p);
+  }
+  __attribute__((target("avx512f"))) static void Store(double* p, Vec v) {
+    _mm512_storeu_pd(p, v);
+  }
+  __attribute__((target("avx512f"))) static Vec Set(double x) {
+    return _mm512_set1_pd(x);
+  }
+  __attribute__((target("avx512f"))) static Vec Add(Vec a, Vec b) {
+    return _mm512_add_pd(a, b);
+  }
+  __attribute__((target("avx512f"))) static Vec Sub(Vec a, Vec b) {
+    return _mm512_sub_pd(a, b);
+  }
+  __attribute__((target("avx512f"))) static Vec Mul(Vec a, Vec b) {
+    return _mm512_mul_pd(a, b);
+  }
+  __attribute__((target("avx512f"))) static bool AnyAbsGreater(Vec v,
+                                                               Vec eps) {
+    return _mm512_cmp_pd_mask(_mm512_abs_pd(v), eps, _CMP_GT_OQ) != 0;
+  }
+};
+
+template <>
+struct Avx512<float> {
+  using Vec = __m512;
+  static const int kWidth = 16;
+  __attribute__((target("avx512f"))) static Vec Load(const float* p) {
+    return _mm512_loadu_ps(p);
+  }
+  __attribute__((target("avx512f"))) static void Store(float* p, Vec v) {
+    _mm512_storeu_ps(p, v);
+  }
+  __attribute__((target("avx512f"))) static Vec Set(float x) {
+    return _mm512_set1_ps(x);
+  }
+  __attribute__((target("avx512f"))) static Vec Add(Vec a, Vec b) {
+    return _mm512_add_ps(a, b);
+  }
+  __attribute__((target("avx512f"))) static Vec Sub(Vec a, Vec b) {
+    return _mm512_sub_ps(a, b);
+  }
+  __attribute__((target("avx512f"))) static Vec Mul(Vec a, Vec b) {
+    return _mm512_mul_ps(a, b);
+  }
+  __attribute__((target("avx512f"))) static bool AnyAbsGreater(Vec v,
+                                                               Vec eps) {
+    return _mm512_cmp_ps_mask(_mm512_abs_ps(v), eps, _CMP_GT_OQ) != 0;
+  }
+};
+
+template <class T>
+__attribute__((target("avx512f"))) void AddAvx512(T* dst, const T* src,
+                                                  int size) noexcept {
+  using V = Avx512<T>;
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    V::Store(dst + k, V::Add(V::Load(dst + k), V::Load(src + k)));
+  }
+  AddScalar(dst + k, src + k, size - k);
+}
+
+template <class T>
+__attribute__((target("avx512f"))) void SubAvx512(T* dst, const T* src,
+                                                  int size) noexcept {
+  using V = Avx512<T>;
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    V::Store(dst + k, V::Sub(V::Load(dst + k), V::Load(src + k)));
+  }
+  SubScalar(dst + k, src + k, size - k);
+}
+
+template <class T>
+__attribute__((target("avx512f"))) void ScaleAvx512(T* dst, T factor,
+                                                    int size) noexcept {
+  using V = Avx512<T>;
+  const typename V::Vec f = V::Set(factor);
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    V::Store(dst + k, V::Mul(V::Load(dst + k), f));
+  }
+  ScaleScalar(dst + k, factor, size - k);
+}
+
+template <class T>
+__attribute__((target("avx512f"))) bool EqualAvx512(const T* a, const T* b,
+                                                    int size,
+                                                    T epsilon) noexcept {
+  using V = Avx512<T>;
+  const typename V::Vec eps = V::Set(epsilon);
+  int k = 0;
+  for (; k + V::kWidth <= size; k += V::kWidth) {
+    if (V::AnyAbsGreater(V::Sub(V::Load(a + k), V::Load(b + k)), eps)) {
+      return false;
+    }
+  }
+  return EqualScalar(a + k, b + k, size - k, epsilon);
+}
+
+#endif  // MATRIX_SIMD_X86
+
+// --------------------- DISPATCH ---------------------
+
+template <class T>
+struct Kernels {
+  void (*add)(T*, const T*, int) noexcept;
+  void (*sub)(T*, const T*, int) noexcept;
+  void (*scale)(T*, T, int) noexcept;
+  bool (*equal)(const T*, const T*, int, T) noexcept;
+};
+
+template <class T>
+const Kernels<T>* KernelsFor(Level level) noexcept {
+  static const Kernels<T> scalar = {AddScalar<T>, SubScalar<T>,
+                                    ScaleScalar<T>, EqualScalar<T, T>};
+  const Kernels<T>* output = &scalar;
+#ifdef MATRIX_SIMD_X86
+  static const Kernels<T> sse2 = {AddSse2<T>, SubSse2<T>, ScaleSse2<T>,
+                                  EqualSse2<T>};
+  static const Kernels<T> avx2 = {AddAvx2<T>, SubAvx2<T>, ScaleAvx2<T>,
+                                  EqualAvx2<T>};
+  static const Kernels<T> avx512 = {AddAvx512<T>, SubAvx512<T>,
+                                    ScaleAvx512<T>, EqualAvx512<T>};
+  switch (level) {
+    case Level::kAvx512:
+      output = &avx512;
+      break;
+    case Level::kAvx2:
+      output = &avx2;
+      break;
+    case Level::kSse2:
+      output = &sse2;
+      break;
+    default:
+      break;
+  }
+#else
+  (void)level;
+#endif
+  return output;
+}
+
+template <class T>
+std::atomic<const Kernels<T>*>& Active() noexcept {
+  static std::atomic<const Kernels<T>*> active(KernelsFor<T>(DetectLevel()));
+  return active;
+}
+
+std::atomic<Level>& ActiveLevel() noexcept {
+  static std::atomic<Level> level(DetectLevel());
+  return level;
+}
+
+}  // namespace
+
+Level DetectLevel() noexcept {
+  static const Level detected = [] {
+    Level output = Level::kScalar;
+#ifdef MATRIX_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+      output = Level::kAvx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+      output = Level::kAvx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+      output = Level::kSse2;
+    }
+#endif
+    return output;
+  }();
+  return detected;
+}
+
+Level GetLevel() noexcept { return ActiveLevel().load(); }
+
+void SetLevel(Level level) noexcept {
+  if (level > DetectLevel()) level = DetectLevel();
+  ActiveLevel().store(level);
+  Active<float>().store(KernelsFor<float>(level));
+  Active<double>().store(KernelsFor<double>(level));
+}
+
+void Add(float* dst, const float* src, int size) noexcept {
+  Active<float>().load(std::memory_order_relaxed)->add(dst, src, size);
+}
+
+void Add(double* dst, const double* src, int size) noexcept {
+  Active<double>().load(std::memory_order_relaxed)->add(dst, src, size);
+}
+
+// std::complex<double> is layout-compatible with double[2], so elementwise
+// sums and real scaling run on the underlying doubles.
+void Add(std::complex<double>* dst, const std::complex<double>* src,
+         int size) noexcept {
+  Add(reinterpret_cast<double*>(dst), reinterpret_cast<const double*>(src),
+      2 * size);
+}
+
+void Sub(float* dst, const float* src, int size) noexcept {
+  Active<float>().load(std::memory_order_relaxed)->sub(dst, src, size);
+}
+
+void Sub(double* dst, const double* src, int size) noexcept {
+  Active<double>().load(std::memory_order_relaxed)->sub(dst, src, size);
+}
+
+void Sub(std::complex<double>* dst, const std::complex<double>* src,
+         int size) noexcept {
+  Sub(reinterpret_cast<double*>(dst), reinterpret_cast<const double*>(src),
+      2 * size);
+}
+
+void Scale(float* dst, float factor, int size) noexcept {
+  Active<float>().load(std::memory_order_relaxed)->scale(dst, factor, size);
+}
+
+void Scale(double* dst, double factor, int size) noexcept {
+  Active<double>().load(std::memory_order_relaxed)->scale(dst, factor, size);
+}
+
+void Scale(std::complex<double>* dst, double factor, int size) noexcept {
+  Scale(reinterpret_cast<double*>(dst), factor, 2 * size);
+}
+
+bool Equal(const float* a, const float* b, int size, float epsilon) noexcept {
+  return Active<float>().load(std::memory_order_relaxed)->equal(a, b, size,
+                                                                epsilon);
+}
+
+bool Equal(const double* a, const double* b, int size,
+           double epsilon) noexcept {
+  return Active<double>().load(std::memory_order_relaxed)->equal(a, b, size,
+                                                                 epsilon);
+}
+
+// The modulus of a complex difference has no cheap vector form; stay scalar.
+bool Equal(const std::complex<double>* a, const std::complex<double>* b,
+           int size, double epsilon) noexcept {
+  return EqualScalar(a, b, size, epsilon);
+}
+
+}  // namespace simd
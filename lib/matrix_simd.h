@@ -0,0 +1,41 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_SIMD_H_
+#define _MATRIX_OOP_LIB__MATRIX_SIMD_H_
+
+#include <complex>
+
+namespace simd {
+
+// Instruction sets the elementwise kernels are built for, in increasing order.
+enum class Level { kScalar, kSse2, kAvx2, kAvx512 };
+
+// Best level supported by the running CPU.
+Level DetectLevel() noexcept;
+// Level currently used by the kernels; DetectLevel() unless overridden.
+Level GetLevel() noexcept;
+// Overrides the dispatch level, clamped to DetectLevel().
+void SetLevel(Level level) noexcept;
+
+// dst[i] += src[i]
+void Add(float *dst, const float *src, int size) noexcept;
+void Add(double *dst, const double *src, int size) noexcept;
+void Add(std::complex<double> *dst, const std::complex<double> *src,
+         int size) noexcept;
+// dst[i] -= src[i]
+void Sub(float *dst, const float *src, int size) noexcept;
+void Sub(double *dst, const double *src, int size) noexcept;
+void Sub(std::complex<double> *dst, const std::complex<double> *src,
+         int size) noexcept;
+// dst[i] *= factor
+void Scale(float *dst, float factor, int size) noexcept;
+void Scale(double *dst, double factor, int size) noexcept;
+void Scale(std::complex<double> *dst, double factor, int size) noexcept;
+// true if |a[i] - b[i]| <= epsilon for every i
+bool Equal(const float *a, const float *b, int size, float epsilon) noexcept;
+bool Equal(const double *a, const double *b, int size,
+           double epsilon) noexcept;
+bool Equal(const std::complex<double> *a, const std::complex<double> *b,
+           int size, double epsilon) noexcept;
+
+}  // namespace simd
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_SIMD_H_
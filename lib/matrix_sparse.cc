@@ -0,0 +1,274 @@
+#include "matrix_sparse.h"
+
+#include <algorithm>
+#include <complex>
+#include <stdexcept>
+
+#include "matrix_threads.h"
+
+namespace {
+
+// Below this many stored elements (times columns of the dense operand) a
+// product stays on the calling thread.
+const long kParallelWork = 1L << 15;
+// Smallest range of rows handed to one thread.
+const int kSparseRows = 256;
+
+}  // namespace
+
+// --------------------- BUILDER ---------------------
+
+template <class T>
+BasicSparseMatrix<T>::Builder::Builder(int rows, int cols)
+    : rows_(rows), cols_(cols), entries_() {
+  if (rows_ < 0) {
+    throw std::invalid_argument("Number of rows less than 0.");
+  }
+  if (cols_ < 0) {
+    throw std::invalid_argument("Number of columns less than 0.");
+  }
+}
+
+template <class T>
+void BasicSparseMatrix<T>::Builder::Reserve(int non_zeros) {
+  entries_.reserve(non_zeros);
+}
+
+template <class T>
+void BasicSparseMatrix<T>::Builder::Add(int i, int j, const T& value) {
+  if (i < 0 || i >= rows_ || j < 0 || j >= cols_) {
+    throw std::out_of_range("Index out of range.");
+  }
+  entries_.push_back(Entry{i, j, value});
+}
+
+// Buckets the entries by row with a counting sort, orders each row by column
+// and sums duplicates while copying them out.
+template <class T>
+BasicSparseMatrix<T> BasicSparseMatrix<T>::Builder::Build() const {
+  BasicSparseMatrix result(rows_, cols_);
+  std::vector<int> starts(rows_ + 1, 0);
+  for (const Entry& entry : entries_) {
+    ++starts[entry.row + 1];
+  }
+  for (int i = 0; i < rows_; ++i) {
+    starts[i + 1] += starts[i];
+  }
+  std::vector<Entry> sorted(entries_.size());
+  std::vector<int> next(starts.begin(), starts.end() - 1);
+  for (const Entry& entry : entries_) {
+    sorted[next[entry.row]++] = entry;
+  }
+  result.columns_.reserve(entries_.size());
+  result.values_.reserve(entries_.size());
+  for (int i = 0; i < rows_; ++i) {
+    auto begin = sorted.begin() + starts[i];
+    auto end = sorted.begin() + starts[i + 1];
+    std::sort(begin, end, [](const Entry& a, const Entry& b) {
+      return a.col < b.col;
+    });
+    int last_col = -1;
+    for (auto it = begin; it != end; ++it) {
+      if (it->col == last_col) {
+        result.values_.back() += it->value;
+      } else {
+        result.columns_.push_back(it->col);
+        result.values_.push_back(it->value);
+        last_col = it->col;
+      }
+    }
+    result.row_offsets_[i + 1] = static_cast<int>(result.columns_.size());
+  }
+  return result;
+}
+
+// --------------------- CREATION ---------------------
+
+template <class T>
+BasicSparseMatrix<T>::BasicSparseMatrix()
+    : rows_(0), cols_(0), row_offsets_(1, 0), columns_(), values_() {}
+
+template <class T>
+BasicSparseMatrix<T>::BasicSparseMatrix(int rows, int cols)
+    : rows_(rows), cols_(cols), row_offsets_(), columns_(), values_() {
+  if (rows_ < 0) {
+    throw std::invalid_argument("Number of rows less than 0.");
+  }
+  if (cols_ < 0) {
+    throw std::invalid_argument("Number of columns less than 0.");
+  }
+  row_offsets_.assign(rows_ + 1, 0);
+}
+
+template <class T>
+BasicSparseMatrix<T>::BasicSparseMatrix(const BasicMatrix<T>& dense,
+                                        Real threshold)
+    : BasicSparseMatrix(dense.GetRows(), dense.GetCols()) {
+  const T* data = dense.Data();
+  int non_zeros = 0;
+  for (int k = 0; k < rows_ * cols_; ++k) {
+    if (std::abs(data[k]) > threshold) ++non_zeros;
+  }
+  columns_.reserve(non_zeros);
+  values_.reserve(non_zeros);
+  for (int i = 0; i < rows_; ++i) {
+    const T* row = data + i * cols_;
+    for (int j = 0; j < cols_; ++j) {
+      if (std::abs(row[j]) > threshold) {
+        columns_.push_back(j);
+        values_.push_back(row[j]);
+      }
+    }
+    row_offsets_[i + 1] = static_cast<int>(columns_.size());
+  }
+}
+
+template <class T>
+BasicSparseMatrix<T>::operator BasicMatrix<T>() const {
+  BasicMatrix<T> result(rows_, cols_);
+  T* data = result.Data();
+  for (int i = 0; i < rows_; ++i) {
+    for (int k = row_offsets_[i]; k < row_offsets_[i + 1]; ++k) {
+      data[i * cols_ + columns_[k]] = values_[k];
+    }
+  }
+  return result;
+}
+
+// --------------------- ACCESSORS ---------------------
+
+template <class T>
+int BasicSparseMatrix<T>::GetRows() const noexcept { return rows_; }
+
+template <class T>
+int BasicSparseMatrix<T>::GetCols() const noexcept { return cols_; }
+
+template <class T>
+int BasicSparseMatrix<T>::GetNonZeros() const noexcept {
+  return static_cast<int>(values_.size());
+}
+
+template <class T>
+const std::vector<int>& BasicSparseMatrix<T>::GetRowOffsets() const noexcept {
+  return row_offsets_;
+}
+
+template <class T>
+const std::vector<int>& BasicSparseMatrix<T>::GetColumns() const noexcept {
+  return columns_;
+}
+
+template <class T>
+const std::vector<T>& BasicSparseMatrix<T>::GetValues() const noexcept {
+  return values_;
+}
+
+template <class T>
+T BasicSparseMatrix<T>::operator()(int i, int j) const {
+  if (i < 0 || i >= rows_ || j < 0 || j >= cols_) {
+    throw std::out_of_range("Index out of range.");
+  }
+  const auto begin = columns_.begin() + row_offsets_[i];
+  const auto end = columns_.begin() + row_offsets_[i + 1];
+  const auto it = std::lower_bound(begin, end, j);
+  T output = T();
+  if (it != end && *it == j) {
+    output = values_[it - columns_.begin()];
+  }
+  return output;
+}
+
+// --------------------- OPERATIONS ---------------------
+
+// Counting sort of the entries by column. Rows are visited in order, so the
+// columns of every transposed row come out sorted.
+template <class T>
+BasicSparseMatrix<T> BasicSparseMatrix<T>::Transpose() const {
+  BasicSparseMatrix result(cols_, rows_);
+  const int non_zeros = GetNonZeros();
+  for (int k = 0; k < non_zeros; ++k) {
+    ++result.row_offsets_[columns_[k] + 1];
+  }
+  for (int j = 0; j < cols_; ++j) {
+    result.row_offsets_[j + 1] += result.row_offsets_[j];
+  }
+  result.columns_.resize(non_zeros);
+  result.values_.resize(non_zeros);
+  std::vector<int> next(result.row_offsets_.begin(),
+                        result.row_offsets_.end() - 1);
+  for (int i = 0; i < rows_; ++i) {
+    for (int k = row_offsets_[i]; k < row_offsets_[i + 1]; ++k) {
+      const int position = next[columns_[k]]++;
+      result.columns_[position] = i;
+      result.values_[position] = values_[k];
+    }
+  }
+  return result;
+}
+
+template <class T>
+std::vector<T> BasicSparseMatrix<T>::operator*(const std::vector<T>& x) const {
+  if (static_cast<int>(x.size()) != cols_) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  std::vector<T> result(rows_);
+  Multiply(x.data(), result.data());
+  return result;
+}
+
+// Rows of y are independent dot products, so threads take row ranges.
+template <class T>
+void BasicSparseMatrix<T>::Multiply(const T* x, T* y) const {
+  auto rows = [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      T sum = T();
+      for (int k = row_offsets_[i]; k < row_offsets_[i + 1]; ++k) {
+        sum += values_[k] * x[columns_[k]];
+      }
+      y[i] = sum;
+    }
+  };
+  if (GetNonZeros() < kParallelWork) {
+    rows(0, rows_);
+  } else {
+    threads::ParallelFor(rows_, kSparseRows, rows);
+  }
+}
+
+// Row i of the product is the sum of the rows of dense selected by the
+// non-zeros of row i, each added as a contiguous axpy.
+template <class T>
+BasicMatrix<T> BasicSparseMatrix<T>::operator*(
+    const BasicMatrix<T>& dense) const {
+  if (cols_ != dense.GetRows()) {
+    throw std::invalid_argument(
+        "The number of columns of the first matrix is not equal to the number "
+        "of rows of the second matrix.");
+  }
+  const int n = dense.GetCols();
+  BasicMatrix<T> result(rows_, n);
+  const T* b = dense.Data();
+  T* c = result.Data();
+  auto rows = [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      T* c_row = c + i * n;
+      for (int k = row_offsets_[i]; k < row_offsets_[i + 1]; ++k) {
+        const T value = values_[k];
+        const T* b_row = b + columns_[k] * n;
+        for (int j = 0; j < n; ++j) {
+          c_row[j] += value * b_row[j];
+        }
+      }
+    }
+  };
+  if (static_cast<long>(GetNonZeros()) * n < kParallelWork) {
+    rows(0, rows_);
+  } else {
+    threads::ParallelFor(rows_, kSparseRows, rows);
+  }
+  return result;
+}
+
+template class BasicSparseMatrix<float>;
+template class BasicSparseMatrix<double>;
+template class BasicSparseMatrix<std::complex<double>>;
@@ -0,0 +1,83 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_SPARSE_H_
+#define _MATRIX_OOP_LIB__MATRIX_SPARSE_H_
+
+#include <vector>
+
+#include "matrix_oop.h"
+
+// Sparse matrix in compressed sparse row (CSR) form: the non-zeros of row i
+// are GetValues()[k] at columns GetColumns()[k] for k in
+// [GetRowOffsets()[i], GetRowOffsets()[i + 1]), sorted by column. Assembled
+// through a Builder from unordered (row, column, value) triplets, or
+// converted from a dense matrix. Instantiated for float, double and
+// std::complex<double>.
+template <class T>
+class BasicSparseMatrix {
+ public:
+  using ValueType = T;
+  using Real = typename MatrixTraits<T>::Real;
+
+  // Coordinate (COO) list of entries in any order; duplicates are summed.
+  class Builder {
+   public:
+    Builder(int rows, int cols);
+
+    void Reserve(int non_zeros);
+    void Add(int i, int j, const T &value);
+    BasicSparseMatrix Build() const;
+
+   private:
+    struct Entry {
+      int row = 0;
+      int col = 0;
+      T value = T();
+    };
+
+    int rows_, cols_;
+    std::vector<Entry> entries_;
+  };
+
+  BasicSparseMatrix();
+  // All-zero matrix of the given shape.
+  BasicSparseMatrix(int rows, int cols);
+  // Keeps the elements of dense with an absolute value above threshold.
+  explicit BasicSparseMatrix(const BasicMatrix<T> &dense,
+                             Real threshold = MatrixTraits<T>::kTolerance);
+
+  explicit operator BasicMatrix<T>() const;
+
+  int GetRows() const noexcept;
+  int GetCols() const noexcept;
+  int GetNonZeros() const noexcept;
+  const std::vector<int> &GetRowOffsets() const noexcept;
+  const std::vector<int> &GetColumns() const noexcept;
+  const std::vector<T> &GetValues() const noexcept;
+
+  // Element (i, j), zero when it is not stored.
+  T operator()(int i, int j) const;
+
+  BasicSparseMatrix Transpose() const;
+
+  // y = A * x for a dense vector of GetCols() elements.
+  std::vector<T> operator*(const std::vector<T> &x) const;
+  // Raw form of the product above; y receives GetRows() elements.
+  void Multiply(const T *x, T *y) const;
+  // Sparse times dense matrix product.
+  BasicMatrix<T> operator*(const BasicMatrix<T> &dense) const;
+
+ private:
+  int rows_, cols_;
+  std::vector<int> row_offsets_;
+  std::vector<int> columns_;
+  std::vector<T> values_;
+};
+
+using SparseMatrix = BasicSparseMatrix<double>;
+using FloatSparseMatrix = BasicSparseMatrix<float>;
+using ComplexSparseMatrix = BasicSparseMatrix<std::complex<double>>;
+
+extern template class BasicSparseMatrix<float>;
+extern template class BasicSparseMatrix<double>;
+extern template class BasicSparseMatrix<std::complex<double>>;
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_SPARSE_H_
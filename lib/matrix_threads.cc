@@ -0,0 +1,209 @@
+#include "matrix_threads.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace threads {
+
+namespace {
+
+thread_local bool in_parallel_region = false;
+
+// Fixed set of workers that execute the tasks of one Run() call at a time.
+// The calling thread takes part in the work, so a pool of size n owns n - 1
+// worker threads.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int size);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int GetSize() const noexcept;
+  void Run(int tasks, const std::function<void(int)>& task);
+
+ private:
+  std::vector<std::thread> workers_;
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const std::function<void(int)> *task_;
+  int tasks_;
+  int next_;
+  int unfinished_;
+  unsigned long generation_;
+  bool stop_;
+
+  void WorkerLoop();
+  void Drain(std::unique_lock<std::mutex>& lock);
+};
+
+ThreadPool::ThreadPool(int size)
+    : workers_(),
+      run_mutex_(),
+      mutex_(),
+      wake_(),
+      done_(),
+      task_(nullptr),
+      tasks_(0),
+      next_(0),
+      unfinished_(0),
+      generation_(0),
+      stop_(false) {
+  for (int i = 1; i < size; ++i) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+int ThreadPool::GetSize() const noexcept {
+  return static_cast<int>(workers_.size()) + 1;
+}
+
+void ThreadPool::Run(int tasks, const std::function<void(int)>& task) {
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  task_ = &task;
+  tasks_ = tasks;
+  next_ = 0;
+  unfinished_ = tasks;
+  ++generation_;
+  wake_.notify_all();
+  Drain(lock);
+  done_.wait(lock, [this] { return unfinished_ == 0; });
+  task_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+  in_parallel_region = true;
+  unsigned long seen = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+    if (stop_) break;
+    seen = generation_;
+    Drain(lock);
+  }
+}
+
+// Claims and runs tasks of the current generation until none are left.
+void ThreadPool::Drain(std::unique_lock<std::mutex>& lock) {
+  const bool was_parallel = in_parallel_region;
+  in_parallel_region = true;
+  while (task_ != nullptr && next_ < tasks_) {
+    const std::function<void(int)>& task = *task_;
+    int index = next_++;
+    lock.unlock();
+    task(index);
+    lock.lock();
+    if (--unfinished_ == 0) done_.notify_all();
+  }
+  in_parallel_region = was_parallel;
+}
+
+int DefaultNumThreads() noexcept {
+  int output = 0;
+  const char* env = std::getenv(kNumThreadsEnv);
+  if (env != nullptr) {
+    output = std::atoi(env);
+  }
+  if (output <= 0) {
+    output = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  return (output > 0) ? output : 1;
+}
+
+std::mutex pool_mutex;
+std::shared_ptr<ThreadPool> pool;
+
+std::shared_ptr<ThreadPool> GetPool() {
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  if (!pool) {
+    pool = std::make_shared<ThreadPool>(DefaultNumThreads());
+  }
+  return pool;
+}
+
+}  // namespace
+
+int GetNumThreads() noexcept {
+  int output = 1;
+  try {
+    output = GetPool()->GetSize();
+  } catch (...) {
+  }
+  return output;
+}
+
+void SetNumThreads(int count) {
+  if (count <= 0) count = DefaultNumThreads();
+  std::shared_ptr<ThreadPool> replacement = std::make_shared<ThreadPool>(count);
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  pool.swap(replacement);
+}
+
+int GetConcurrency() noexcept {
+  return in_parallel_region ? 1 : GetNumThreads();
+}
+
+void ParallelFor(int count, int min_chunk,
+                 const std::function<void(int, int)>& body) {
+  if (count <= 0) return;
+  if (min_chunk < 1) min_chunk = 1;
+  std::shared_ptr<ThreadPool> current;
+  int chunks = 1;
+  if (!in_parallel_region && count >= 2 * min_chunk) {
+    current = GetPool();
+    chunks = std::min(current->GetSize(), count / min_chunk);
+  }
+  if (chunks <= 1) {
+    body(0, count);
+    return;
+  }
+  // The first exception is kept and rethrown on the calling thread once every
+  // range has returned; ranges that have not started by then are skipped.
+  // The state is captured through a single reference, which std::function
+  // stores inline, so a parallel call does not allocate.
+  struct Split {
+    const std::function<void(int, int)>& body;
+    const int base;
+    const int extra;
+    std::atomic<bool> failed;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+  } split{body, count / chunks, count % chunks, {false}, {}, {}};
+  current->Run(chunks, [&split](int chunk) {
+    if (split.failed.load()) return;
+    const int begin = chunk * split.base + std::min(chunk, split.extra);
+    const int end = begin + split.base + (chunk < split.extra ? 1 : 0);
+    try {
+      split.body(begin, end);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(split.error_mutex);
+      if (!split.error) split.error = std::current_exception();
+      split.failed.store(true);
+    }
+  });
+  if (split.error) std::rethrow_exception(split.error);
+}
+
+}  // namespace threads
@@ -0,0 +1,31 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_THREADS_H_
+#define _MATRIX_OOP_LIB__MATRIX_THREADS_H_
+
+#include <functional>
+
+namespace threads {
+
+// Name of the environment variable read for the initial thread count.
+const char kNumThreadsEnv[] = "MATRIX_NUM_THREADS";
+
+// Number of threads used by the library kernels, the calling thread included.
+// Defaults to $MATRIX_NUM_THREADS, or to the hardware concurrency when the
+// variable is unset or invalid.
+int GetNumThreads() noexcept;
+// Resizes the library thread pool; 0 restores the default.
+void SetNumThreads(int count);
+// Threads a ParallelFor called from here can spread over: 1 inside another
+// parallel region, where it runs inline, and GetNumThreads() otherwise.
+int GetConcurrency() noexcept;
+
+// Splits [0, count) into contiguous ranges of at least min_chunk items and
+// calls body(begin, end) for each of them on the pool. Runs inline when a
+// single range results or when called from inside another parallel region.
+// If body throws, ranges not yet started are skipped and the first exception
+// is rethrown on the calling thread after the running ones have returned.
+void ParallelFor(int count, int min_chunk,
+                 const std::function<void(int, int)> &body);
+
+}  // namespace threads
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_THREADS_H_
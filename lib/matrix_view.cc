@@ -0,0 +1,82 @@
+#include "matrix_view.h"
+
+#include <algorithm>
+#include <complex>
+#include <functional>
+
+#include "matrix_gemm.h"
+
+namespace {
+
+// True when the elements spanned by the two views share memory. Compares
+// the address ranges from the first to one past the last element, so two
+// interleaved but disjoint column blocks of a matrix count as overlapping.
+template <class T>
+bool Overlap(BasicMatrixView<const T> a, BasicMatrixView<const T> b) {
+  if (a.GetRows() == 0 || a.GetCols() == 0 || b.GetRows() == 0 ||
+      b.GetCols() == 0) {
+    return false;
+  }
+  const T* a_end = a.Data() + (a.GetRows() - 1) * a.GetStride() + a.GetCols();
+  const T* b_end = b.Data() + (b.GetRows() - 1) * b.GetStride() + b.GetCols();
+  std::less<const T*> less;
+  return less(a.Data(), b_end) && less(b.Data(), a_end);
+}
+
+template <class T>
+void GemmView(T alpha, BasicMatrixView<const T> a, bool trans_a,
+              BasicMatrixView<const T> b, bool trans_b, T beta,
+              BasicMatrixView<T> c) {
+  const int m = trans_a ? a.GetCols() : a.GetRows();
+  const int k = trans_a ? a.GetRows() : a.GetCols();
+  const int n = trans_b ? b.GetRows() : b.GetCols();
+  if ((trans_b ? b.GetCols() : b.GetRows()) != k) {
+    throw std::invalid_argument(
+        "The number of columns of the first matrix is not equal to the number "
+        "of rows of the second matrix.");
+  }
+  if (c.GetRows() != m || c.GetCols() != n) {
+    throw std::invalid_argument("Different matrix dimensions.");
+  }
+  if (Overlap<T>(a, c)) {
+    const BasicMatrix<T> copy(a);
+    GemmView<T>(alpha, copy, trans_a, b, trans_b, beta, c);
+    return;
+  }
+  if (Overlap<T>(b, c)) {
+    const BasicMatrix<T> copy(b);
+    GemmView<T>(alpha, a, trans_a, copy, trans_b, beta, c);
+    return;
+  }
+  if (beta == T(0)) {
+    for (int i = 0; i < m; ++i) {
+      std::fill(c.Data() + i * c.GetStride(),
+                c.Data() + i * c.GetStride() + n, T());
+    }
+  } else if (beta != T(1)) {
+    c *= beta;
+  }
+  gemm::Multiply(trans_a ? gemm::Op::kTrans : gemm::Op::kNoTrans,
+                 trans_b ? gemm::Op::kTrans : gemm::Op::kNoTrans, m, n, k,
+                 alpha, a.Data(), a.GetStride(), b.Data(), b.GetStride(),
+                 c.Data(), c.GetStride());
+}
+
+}  // namespace
+
+void Gemm(float alpha, ConstFloatMatrixView a, bool trans_a,
+          ConstFloatMatrixView b, bool trans_b, float beta,
+          FloatMatrixView c) {
+  GemmView<float>(alpha, a, trans_a, b, trans_b, beta, c);
+}
+
+void Gemm(double alpha, ConstMatrixView a, bool trans_a, ConstMatrixView b,
+          bool trans_b, double beta, MatrixView c) {
+  GemmView<double>(alpha, a, trans_a, b, trans_b, beta, c);
+}
+
+void Gemm(std::complex<double> alpha, ConstComplexMatrixView a, bool trans_a,
+          ConstComplexMatrixView b, bool trans_b, std::complex<double> beta,
+          ComplexMatrixView c) {
+  GemmView<std::complex<double>>(alpha, a, trans_a, b, trans_b, beta, c);
+}
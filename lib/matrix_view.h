@@ -0,0 +1,176 @@
+#ifndef _MATRIX_OOP_LIB__MATRIX_VIEW_H_
+#define _MATRIX_OOP_LIB__MATRIX_VIEW_H_
+
+#include <stdexcept>
+#include <type_traits>
+
+#include "matrix_oop.h"
+
+// Non-owning window onto a rectangle of row-major elements: GetRows() x
+// GetCols() elements, element (i, j) at Data()[i * GetStride() + j]. Row,
+// column and block slices of a matrix are views of its buffer, so taking one
+// copies nothing and writing through one changes the matrix. A view must not
+// outlive its matrix, and moving a small (inline) matrix invalidates them.
+// BasicMatrixView<const T> is the read-only flavour; a mutable view converts
+// to it. Views are expressions: they mix with matrices in +, - and scalar *,
+// and a Matrix is constructed or assigned from one by copying the elements.
+template <class T>
+class BasicMatrixView {
+ public:
+  using ValueType = std::remove_const_t<T>;
+  using MatrixType = BasicMatrix<ValueType>;
+
+  BasicMatrixView() noexcept
+      : data_(nullptr), rows_(0), cols_(0), stride_(0) {}
+
+  BasicMatrixView(T *data, int rows, int cols, int stride)
+      : data_(data), rows_(rows), cols_(cols), stride_(stride) {
+    if (rows_ < 0) {
+      throw std::invalid_argument("Number of rows less than 0.");
+    }
+    if (cols_ < 0) {
+      throw std::invalid_argument("Number of columns less than 0.");
+    }
+    if (stride_ < cols_) {
+      throw std::invalid_argument("Row stride less than number of columns.");
+    }
+  }
+
+  // The whole of matrix.
+  BasicMatrixView(MatrixType &matrix) noexcept
+      : data_(matrix.Data()),
+        rows_(matrix.GetRows()),
+        cols_(matrix.GetCols()),
+        stride_(matrix.GetCols()) {}
+
+  template <class U = T, class = std::enable_if_t<std::is_const<U>::value>>
+  BasicMatrixView(const MatrixType &matrix) noexcept
+      : data_(matrix.Data()),
+        rows_(matrix.GetRows()),
+        cols_(matrix.GetCols()),
+        stride_(matrix.GetCols()) {}
+
+  // Read-only view of a mutable one.
+  template <class U, class = std::enable_if_t<std::is_same<const U, T>::value &&
+                                              !std::is_same<U, T>::value>>
+  BasicMatrixView(const BasicMatrixView<U> &other) noexcept
+      : data_(other.Data()),
+        rows_(other.GetRows()),
+        cols_(other.GetCols()),
+        stride_(other.GetStride()) {}
+
+  int GetRows() const noexcept { return rows_; }
+  int GetCols() const noexcept { return cols_; }
+  int GetStride() const noexcept { return stride_; }
+  T *Data() const noexcept { return data_; }
+
+  T &operator()(int i, int j) const {
+    if (i < 0 || i >= rows_ || j < 0 || j >= cols_) {
+      throw std::out_of_range("Index out of range.");
+    }
+    return At(i, j);
+  }
+  // Unchecked access, used when the view is evaluated as an expression.
+  T &At(int i, int j) const noexcept { return data_[i * stride_ + j]; }
+
+  // rows x cols elements starting at (i, j).
+  BasicMatrixView Block(int i, int j, int rows, int cols) const {
+    if (i < 0 || j < 0 || rows < 0 || cols < 0 || i + rows > rows_ ||
+        j + cols > cols_) {
+      throw std::out_of_range("Index out of range.");
+    }
+    return BasicMatrixView(data_ + i * stride_ + j, rows, cols, stride_);
+  }
+  // Row i as a 1 x GetCols() view.
+  BasicMatrixView Row(int i) const { return Block(i, 0, 1, cols_); }
+  // Column j as a GetRows() x 1 view.
+  BasicMatrixView Col(int j) const { return Block(0, j, rows_, 1); }
+
+  // Elementwise updates of the viewed elements from a matrix, view or
+  // expression of the same shape. The operand may read the elements being
+  // written only at the same position, so it must not be a shifted view
+  // that overlaps this one.
+  template <class E, class = expr::EnableIfOperand<E>>
+  const BasicMatrixView &Assign(const E &operand) const {
+    Update(operand, [](T &x, const ValueType &y) { x = y; });
+    return *this;
+  }
+  template <class E, class = expr::EnableIfOperand<E>>
+  const BasicMatrixView &operator+=(const E &operand) const {
+    Update(operand, [](T &x, const ValueType &y) { x += y; });
+    return *this;
+  }
+  template <class E, class = expr::EnableIfOperand<E>>
+  const BasicMatrixView &operator-=(const E &operand) const {
+    Update(operand, [](T &x, const ValueType &y) { x -= y; });
+    return *this;
+  }
+  const BasicMatrixView &operator*=(const ValueType &number) const {
+    for (int i = 0; i < rows_; ++i) {
+      T *row = data_ + i * stride_;
+      for (int j = 0; j < cols_; ++j) {
+        row[j] *= number;
+      }
+    }
+    return *this;
+  }
+
+  // Read through the stride straight into the transposed matrix.
+  MatrixType Transpose() const {
+    return MatrixType::Transposed(data_, rows_, cols_, stride_);
+  }
+  // The elimination works on a copy, so only the factorization allocates.
+  ValueType Determinant() const { return MatrixType(*this).Determinant(); }
+
+ private:
+  T *data_;
+  int rows_, cols_, stride_;
+
+  template <class E, class F>
+  void Update(const E &operand, F apply) const {
+    static_assert(!std::is_const<T>::value, "Writing through a const view.");
+    const typename expr::Operand<E>::Type source =
+        expr::Operand<E>::Make(operand);
+    static_assert(std::is_same<typename expr::Operand<E>::Type::ValueType,
+                               ValueType>::value,
+                  "Expression and view element types differ.");
+    if (source.GetRows() != rows_ || source.GetCols() != cols_) {
+      throw std::invalid_argument("Different matrix dimensions.");
+    }
+    for (int i = 0; i < rows_; ++i) {
+      T *row = data_ + i * stride_;
+      for (int j = 0; j < cols_; ++j) {
+        apply(row[j], source.At(i, j));
+      }
+    }
+  }
+};
+
+using MatrixView = BasicMatrixView<double>;
+using ConstMatrixView = BasicMatrixView<const double>;
+using FloatMatrixView = BasicMatrixView<float>;
+using ConstFloatMatrixView = BasicMatrixView<const float>;
+using ComplexMatrixView = BasicMatrixView<std::complex<double>>;
+using ConstComplexMatrixView = BasicMatrixView<const std::complex<double>>;
+
+namespace expr {
+
+template <class T>
+struct IsExpression<BasicMatrixView<T>> : std::true_type {};
+
+}  // namespace expr
+
+// Gemm on views: C = alpha * op(A) * op(B) + beta * C where A, B and C may be
+// blocks of larger matrices, read and written in place through their row
+// strides. Matrices convert to views, so any mix of the two is accepted. An
+// operand that overlaps C is copied first.
+void Gemm(float alpha, ConstFloatMatrixView a, bool trans_a,
+          ConstFloatMatrixView b, bool trans_b, float beta,
+          FloatMatrixView c);
+void Gemm(double alpha, ConstMatrixView a, bool trans_a, ConstMatrixView b,
+          bool trans_b, double beta, MatrixView c);
+void Gemm(std::complex<double> alpha, ConstComplexMatrixView a, bool trans_a,
+          ConstComplexMatrixView b, bool trans_b, std::complex<double> beta,
+          ComplexMatrixView c);
+
+#endif  // _MATRIX_OOP_LIB__MATRIX_VIEW_H_
@@ -1,6 +1,60 @@
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <memory_resource>
+#include <sstream>
+
+#include "matrix_batch.h"
+#include "matrix_cholesky.h"
+#include "matrix_fixed.h"
+#include "matrix_gemm.h"
+#include "matrix_io.h"
+#include "matrix_memory.h"
 #include "matrix_oop.h"
+#include "matrix_qr.h"
+#include "matrix_simd.h"
+#include "matrix_sparse.h"
+#include "matrix_threads.h"
+#include "matrix_view.h"
+
+namespace {
+
+// Forwards to new_delete_resource() and counts the allocations, from any
+// thread. Static, so that it outlives the packing buffers that grow from it
+// while it is the default resource.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  CountingResource() : allocations_(0) {}
+
+  long GetAllocations() const noexcept { return allocations_.load(); }
+
+ private:
+  std::atomic<long> allocations_;
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations_;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+CountingResource counting_resource;
+
+}  // namespace
 
 TEST(TestMemory, Many_rows) {
   int rows = -2;
@@ -505,6 +559,30 @@ TEST(TestMatrixMul, Mul_matrix_operator) {
   }
 }
 
+TEST(TestMatrixMul, Mul_matrix_blocked) {
+  int m = 133, k = 301, n = 67;
+  Matrix M(m, k);
+  Matrix N(k, n);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < k; ++j) M(i, j) = ((i * 31 + j * 17) % 23) / 23.0;
+  }
+  for (int i = 0; i < k; ++i) {
+    for (int j = 0; j < n; ++j) N(i, j) = ((i * 13 + j * 29) % 19) / 19.0;
+  }
+
+  Matrix R = M * N;
+
+  ASSERT_EQ(m, R.GetRows());
+  ASSERT_EQ(n, R.GetCols());
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      double expected = 0;
+      for (int p = 0; p < k; ++p) expected += M(i, p) * N(p, j);
+      ASSERT_NEAR(expected, R(i, j), kEpsilon);
+    }
+  }
+}
+
 TEST(TestTransposeMatrix, Transpose_1) {
   Matrix M(2, 2);
   M(0, 0) = 1;
@@ -551,6 +629,46 @@ TEST(TestTransposeMatrix, Transpose_2) {
   }
 }
 
+TEST(TestTransposeMatrix, Transpose_tiled) {
+  int rows = 70;
+  int cols = 45;
+  Matrix M(rows, cols);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) M(i, j) = i * cols + j;
+  }
+
+  Matrix R = M.Transpose();
+
+  ASSERT_EQ(cols, R.GetRows());
+  ASSERT_EQ(rows, R.GetCols());
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) ASSERT_EQ(M(i, j), R(j, i));
+  }
+}
+
+TEST(TestTransposeMatrix, Transpose_in_place) {
+  int size = 67;
+  Matrix M(size, size);
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) M(i, j) = i * size + j;
+  }
+  Matrix R = M.Transpose();
+
+  M.TransposeInPlace();
+
+  ASSERT_EQ(R, M);
+}
+
+TEST(TestTransposeMatrix, Transpose_in_place_not_square) {
+  Matrix M(2, 3);
+  try {
+    M.TransposeInPlace();
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("The matrix is not square.", ex.what());
+  }
+}
+
 TEST(TestInverseMatrix, Inverse_1) {
   Matrix M(2, 2);
   M(0, 0) = 1;
@@ -568,7 +686,7 @@ TEST(TestInverseMatrix, Inverse_1) {
 
   for (int i = 0; i < 2; ++i) {
     for (int j = 0; j < 2; ++j) {
-      ASSERT_EQ(RealRes(i, j), R(i, j));
+      ASSERT_NEAR(RealRes(i, j), R(i, j), kEpsilon);
     }
   }
 }
@@ -615,7 +733,7 @@ TEST(TestInverseMatrix, Inverse_3) {
 
   for (int i = 0; i < R.GetRows(); ++i) {
     for (int j = 0; j < R.GetCols(); ++j) {
-      ASSERT_DOUBLE_EQ(RealRes(i, j), R(i, j));
+      ASSERT_NEAR(RealRes(i, j), R(i, j), kEpsilon);
     }
   }
 }
@@ -646,6 +764,24 @@ TEST(TestInverseMatrix, Inverse_loop) {
   ASSERT_NEAR(M(2, 2), 1, kEpsilon);
 }
 
+TEST(TestInverseMatrix, Inverse_large) {
+  int size = 64;
+  Matrix M(size, size);
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) {
+      M(i, j) = (i == j) ? size : ((i * 7 + j * 13) % 11) / 11.0;
+    }
+  }
+
+  Matrix R = M * M.InverseMatrix();
+
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) {
+      ASSERT_NEAR(R(i, j), (i == j) ? 1 : 0, kEpsilon);
+    }
+  }
+}
+
 TEST(TestDeterminant, Det_1) {
   Matrix M(2, 2);
   M(0, 0) = 1;
@@ -692,6 +828,69 @@ TEST(TestDeterminant, Det_4) {
   ASSERT_DOUBLE_EQ(R, 109.56);
 }
 
+TEST(TestDeterminant, Det_large) {
+  int size = 12;
+  Matrix M(size, size);
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) {
+      M(i, j) = (i == j) ? 2 : 0;
+    }
+    if (i + 1 < size) M(i, i + 1) = 1;
+  }
+  M(size - 1, 0) = 1;
+
+  double R = M.Determinant();
+  ASSERT_NEAR(R, 4096 - 1, kEpsilon * 4096);
+}
+
+TEST(TestDeterminant, Lu_pivoting) {
+  Matrix M(3, 3);
+  M(0, 0) = 0;
+  M(0, 1) = 2;
+  M(0, 2) = 1;
+  M(1, 0) = 4;
+  M(1, 1) = 1;
+  M(1, 2) = 3;
+  M(2, 0) = 2;
+  M(2, 1) = 5;
+  M(2, 2) = 7;
+
+  LuFactor lu = M.Lu();
+  const Matrix& packed = lu.GetLu();
+  Matrix L(3, 3);
+  Matrix U(3, 3);
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      if (i > j) L(i, j) = packed(i, j);
+      if (i == j) L(i, j) = 1;
+      if (i <= j) U(i, j) = packed(i, j);
+    }
+  }
+  Matrix PA = M;
+  for (int k = 0; k < 3; ++k) {
+    int p = lu.GetPivots()[k];
+    for (int j = 0; j < 3; ++j) std::swap(PA(k, j), PA(p, j));
+  }
+
+  ASSERT_EQ(1, lu.GetPivots()[0]);
+  ASSERT_FALSE(lu.IsSingular());
+  ASSERT_EQ(PA, L * U);
+  ASSERT_NEAR(M.Determinant(), -26, kEpsilon);
+  ASSERT_NEAR(lu.Determinant(), -26, kEpsilon);
+}
+
+TEST(TestDeterminant, Lu_singular) {
+  Matrix M(3, 3);
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      M(i, j) = i * 3 + j + 1;
+    }
+  }
+
+  ASSERT_TRUE(M.Lu().IsSingular());
+  ASSERT_NEAR(M.Determinant(), 0, kEpsilon);
+}
+
 TEST(TestCalcComp, Matrix_3) {
   Matrix M(3, 3);
   M(0, 0) = 1;
@@ -719,7 +918,67 @@ TEST(TestCalcComp, Matrix_3) {
 
   for (int i = 0; i < 3; ++i) {
     for (int j = 0; j < 3; ++j) {
-      ASSERT_EQ(RealRes(i, j), R(i, j));
+      ASSERT_NEAR(RealRes(i, j), R(i, j), kEpsilon);
+    }
+  }
+}
+
+TEST(TestCalcComp, Singular_rank_n_minus_1) {
+  Matrix M(3, 3);
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      M(i, j) = i * 3 + j + 1;
+    }
+  }
+
+  Matrix R = M.CalcComplements();
+
+  Matrix RealRes(3, 3);
+  RealRes(0, 0) = -3;
+  RealRes(0, 1) = 6;
+  RealRes(0, 2) = -3;
+  RealRes(1, 0) = 6;
+  RealRes(1, 1) = -12;
+  RealRes(1, 2) = 6;
+  RealRes(2, 0) = -3;
+  RealRes(2, 1) = 6;
+  RealRes(2, 2) = -3;
+
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      ASSERT_NEAR(RealRes(i, j), R(i, j), kEpsilon);
+    }
+  }
+}
+
+TEST(TestCalcComp, Singular_rank_1) {
+  Matrix M(4, 4);
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      M(i, j) = (i + 1) * (j + 2);
+    }
+  }
+
+  Matrix R = M.CalcComplements();
+
+  ASSERT_EQ(R, Matrix(4, 4));
+}
+
+TEST(TestCalcComp, Adjugate_identity) {
+  int size = 40;
+  Matrix M(size, size);
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) {
+      M(i, j) = (i == j) ? 1.5 : ((i * 5 + j * 3) % 7) / 70.0;
+    }
+  }
+
+  double det = M.Determinant();
+  Matrix R = M * M.CalcComplements().Transpose();
+
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) {
+      ASSERT_NEAR(R(i, j), (i == j) ? det : 0, kEpsilon * fabs(det));
     }
   }
 }
@@ -737,6 +996,15 @@ TEST(TestCalcComp, Matrix_1) {
   }
 }
 
+TEST(TestCalcComp, Matrix_1_is_empty_minor) {
+  // The cofactor is the determinant of the empty minor, not the element.
+  for (double element : {5.0, 0.0}) {
+    Matrix M(1, 1);
+    M(0, 0) = element;
+    ASSERT_DOUBLE_EQ(1, M.CalcComplements()(0, 0));
+  }
+}
+
 TEST(TestCalcComp, Matrix_4) {
   Matrix M(4, 4);
   M(0, 0) = 9;
@@ -1065,6 +1333,1212 @@ TEST(TestMutator, Set_cols_less) {
   }
 }
 
+TEST(TestMutator, Set_rows_less_then_more) {
+  Matrix M(3, 2);
+  M(0, 0) = 1;
+  M(0, 1) = 2;
+  M(1, 0) = 3;
+  M(1, 1) = 4;
+  M(2, 0) = 5;
+  M(2, 1) = 6;
+
+  M.SetRows(1);
+  M.SetRows(3);
+
+  Matrix RealRes(3, 2);
+  RealRes(0, 0) = 1;
+  RealRes(0, 1) = 2;
+
+  ASSERT_EQ(3, M.GetRows());
+  ASSERT_EQ(2, M.GetCols());
+  ASSERT_EQ(RealRes, M);
+}
+
+TEST(TestSimd, All_levels) {
+  int rows = 7;
+  int cols = 5;
+  Matrix M(rows, cols);
+  Matrix N(rows, cols);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      M(i, j) = i * cols + j;
+      N(i, j) = (i * cols + j) * 0.5;
+    }
+  }
+  const simd::Level levels[] = {simd::Level::kScalar, simd::Level::kSse2,
+                                simd::Level::kAvx2, simd::Level::kAvx512};
+  for (simd::Level level : levels) {
+    simd::SetLevel(level);
+    ASSERT_LE(simd::GetLevel(), simd::DetectLevel());
+
+    Matrix R = M + N;
+    R -= N;
+    ASSERT_EQ(M, R);
+    R *= 3;
+    for (int i = 0; i < rows; ++i) {
+      for (int j = 0; j < cols; ++j) {
+        ASSERT_EQ(3 * M(i, j), R(i, j));
+      }
+    }
+    R = M;
+    R(rows - 1, cols - 1) += 2 * kEpsilon;
+    ASSERT_NE(M, R);
+    R = M;
+    R(0, 0) += 2 * kEpsilon;
+    ASSERT_NE(M, R);
+  }
+  simd::SetLevel(simd::DetectLevel());
+}
+
+TEST(TestThreads, Parallel_mul_and_inverse) {
+  int size = 150;
+  Matrix M(size, size);
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) {
+      M(i, j) = (i == j) ? 4 : ((i * 11 + j * 7) % 13) / 13.0 - 0.5;
+    }
+  }
+  threads::SetNumThreads(1);
+  Matrix serial_product = M * M;
+  double serial_det = M.Determinant();
+  Matrix serial_inverse = M.InverseMatrix();
+
+  threads::SetNumThreads(4);
+  ASSERT_EQ(4, threads::GetNumThreads());
+  Matrix parallel_inverse = M.InverseMatrix();
+  Matrix R = M * parallel_inverse;
+
+  ASSERT_EQ(serial_product, M * M);
+  ASSERT_NEAR(serial_det, M.Determinant(), kEpsilon * fabs(serial_det));
+  ASSERT_EQ(serial_inverse, parallel_inverse);
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) {
+      ASSERT_NEAR(R(i, j), (i == j) ? 1 : 0, kEpsilon);
+    }
+  }
+  threads::SetNumThreads(0);
+}
+
+TEST(TestThreads, Parallel_for_ranges) {
+  threads::SetNumThreads(3);
+  std::vector<int> hits(1000, 0);
+  threads::ParallelFor(1000, 10, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) ++hits[i];
+  });
+  for (int hit : hits) ASSERT_EQ(1, hit);
+  ASSERT_EQ(3, threads::GetConcurrency());
+  std::atomic<int> nested(0);
+  threads::ParallelFor(30, 10, [&](int, int) {
+    nested += threads::GetConcurrency();
+  });
+  ASSERT_EQ(3, nested.load());
+
+  // An exception from any range reaches the caller, and the pool stays
+  // usable afterwards.
+  EXPECT_THROW(threads::ParallelFor(1000, 10,
+                                    [](int begin, int) {
+                                      if (begin > 0) {
+                                        throw std::runtime_error("range");
+                                      }
+                                    }),
+               std::runtime_error);
+  threads::ParallelFor(1000, 10, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) ++hits[i];
+  });
+  for (int hit : hits) ASSERT_EQ(2, hit);
+  threads::SetNumThreads(0);
+}
+
+TEST(TestExpression, Fused_chain) {
+  Matrix A(2, 3);
+  Matrix B(2, 3);
+  Matrix C(2, 3);
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      A(i, j) = i + j;
+      B(i, j) = i * j;
+      C(i, j) = 1;
+    }
+  }
+
+  Matrix R = A + B - C * 2;
+  Matrix S = 3 * (A - B) + A;
+
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      ASSERT_EQ(A(i, j) + B(i, j) - 2, R(i, j));
+      ASSERT_EQ(3 * (A(i, j) - B(i, j)) + A(i, j), S(i, j));
+    }
+  }
+}
+
+TEST(TestExpression, Aliasing_and_resize) {
+  Matrix A(2, 2);
+  Matrix B(2, 2);
+  A(0, 0) = 1;
+  A(1, 1) = 2;
+  B(0, 1) = 5;
+  Matrix Expected = A;
+  Expected(0, 1) = 10;
+
+  A = A + B * 2;
+  ASSERT_EQ(Expected, A);
+
+  Matrix R(5, 1);
+  R = A - B;
+  ASSERT_EQ(2, R.GetRows());
+  ASSERT_EQ(2, R.GetCols());
+  ASSERT_EQ(5, R(0, 1));
+
+  R += A * 2 - B;
+  R -= A;
+  ASSERT_EQ(10, R(0, 1));
+  ASSERT_EQ(4, R(1, 1));
+}
+
+TEST(TestExpression, Different_dimensions) {
+  Matrix A(2, 2);
+  Matrix B(2, 2);
+  Matrix C(2, 3);
+  try {
+    Matrix R = A + B - C;
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+  try {
+    A += C * 2;
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+}
+
+TEST(TestFixed, Constexpr_operations) {
+  constexpr FixedMatrix<2, 3> M{1, 2, 3, 4, 5, 6};
+  constexpr FixedMatrix<3, 2> T = M.Transpose();
+  constexpr FixedMatrix<2, 2> P = M * T;
+  constexpr FixedMatrix<3, 3> A{2, 0, 1, 1, 3, 2, 1, 1, 2};
+  constexpr FixedMatrix<3, 3> I = A * A.InverseMatrix();
+
+  static_assert(T(2, 1) == 6, "transpose");
+  static_assert(P == FixedMatrix<2, 2>{14, 32, 32, 77}, "product");
+  static_assert(A.Determinant() == 6, "determinant");
+  static_assert(I == FixedMatrix<3, 3>{1, 0, 0, 0, 1, 0, 0, 0, 1}, "inverse");
+  static_assert((2 * P - P)(1, 1) == 77, "arithmetic");
+  SUCCEED();
+}
+
+namespace {
+
+// The 4x4 closed forms and the pivoting loops of larger sizes against the
+// dynamic matrix.
+template <int N>
+void ExpectFixedMatchesDynamic() {
+  Matrix M(N, N);
+  for (int i = 0; i < N; ++i) {
+    for (int j = 0; j < N; ++j) {
+      M(i, j) = (i == j) ? 5 : i + 2 * j;
+    }
+  }
+  FixedMatrix<N, N> F(M);
+
+  ASSERT_NEAR(M.Determinant(), F.Determinant(), kEpsilon * 1000);
+  ASSERT_EQ(M.InverseMatrix(), static_cast<Matrix>(F.InverseMatrix()));
+  ASSERT_EQ(M * M, static_cast<Matrix>(F * F));
+  ASSERT_EQ(M.Transpose(), static_cast<Matrix>(F.Transpose()));
+}
+
+}  // namespace
+
+TEST(TestFixed, Matches_dynamic_matrix) {
+  ExpectFixedMatchesDynamic<4>();
+  ExpectFixedMatchesDynamic<5>();
+
+  // Zero leading pivot, which the closed form does not need to avoid.
+  constexpr FixedMatrix<4, 4> P{0, 2, 0, 0, 1, 0, 0, 0,
+                                0, 0, 0, 3, 0, 0, 4, 0};
+  static_assert(P.Determinant() == 24, "4x4 determinant");
+  static_assert(P * P.InverseMatrix() ==
+                    FixedMatrix<4, 4>{1, 0, 0, 0, 0, 1, 0, 0,
+                                      0, 0, 1, 0, 0, 0, 0, 1},
+                "4x4 inverse");
+}
+
+TEST(TestFixed, Errors) {
+  Matrix M(2, 3);
+  try {
+    FixedMatrix<3, 3> F(M);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+  FixedMatrix<5, 5> S;
+  try {
+    S.InverseMatrix();
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("The matrix determinant is 0.", ex.what());
+  }
+  try {
+    FixedMatrix<4, 4>{1, 2, 3, 4, 2, 4, 6, 8}.InverseMatrix();
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("The matrix determinant is 0.", ex.what());
+  }
+  try {
+    S(5, 0);
+    FAIL();
+  } catch (std::out_of_range& ex) {
+    EXPECT_STREQ("Index out of range.", ex.what());
+  }
+}
+
+TEST(TestElementType, Float_matrix) {
+  FloatMatrix A(3, 3);
+  float values[9] = {4, 1, 0, 1, 3, 1, 0, 2, 2};
+  for (int k = 0; k < 9; ++k) {
+    A(k / 3, k % 3) = values[k];
+  }
+  ASSERT_NEAR(A.Determinant(), 14.0f, 1.0E-4f);
+
+  FloatMatrix I(3, 3);
+  for (int i = 0; i < 3; ++i) {
+    I(i, i) = 1;
+  }
+  ASSERT_EQ(A * A.InverseMatrix(), I);
+  FloatMatrix C = A.CalcComplements();
+  ASSERT_NEAR(C(0, 0), 4.0f, 1.0E-4f);
+  ASSERT_NEAR(C(1, 2), -8.0f, 1.0E-4f);
+  ASSERT_NEAR(C(2, 1), -4.0f, 1.0E-4f);
+
+  FloatMatrix B = A + A - A * 2;
+  ASSERT_EQ(B, FloatMatrix(3, 3));
+  A.MulNumber(0.5f);
+  ASSERT_FLOAT_EQ(A(0, 0), 2.0f);
+  ASSERT_FLOAT_EQ(A(2, 1), 1.0f);
+}
+
+TEST(TestElementType, Complex_matrix) {
+  using Complex = std::complex<double>;
+  ComplexMatrix A(2, 2);
+  A(0, 0) = Complex(1, 1);
+  A(0, 1) = Complex(2, 0);
+  A(1, 0) = Complex(0, -1);
+  A(1, 1) = Complex(3, 2);
+  // (1 + i)(3 + 2i) - 2 * (-i) = 1 + 7i
+  Complex det = A.Determinant();
+  ASSERT_NEAR(det.real(), 1, kEpsilon);
+  ASSERT_NEAR(det.imag(), 7, kEpsilon);
+
+  ComplexMatrix I(2, 2);
+  I(0, 0) = I(1, 1) = 1;
+  ASSERT_EQ(A * A.InverseMatrix(), I);
+  ASSERT_EQ(A.InverseMatrix() * A, I);
+
+  ComplexMatrix C = A.CalcComplements();
+  ASSERT_EQ(C(0, 0), A(1, 1));
+  ASSERT_EQ(C(0, 1), -A(1, 0));
+  ASSERT_EQ(C(1, 0), -A(0, 1));
+  ASSERT_EQ(C(1, 1), A(0, 0));
+
+  ComplexMatrix B = (A + A) * 3 - A;
+  A.MulNumber(Complex(0, 5));
+  ASSERT_EQ(B(1, 1), Complex(15, 10));
+  ASSERT_EQ(A(1, 1), Complex(-10, 15));
+  ASSERT_EQ(A.Transpose()(0, 1), Complex(5, 0));
+}
+
+TEST(TestMemory, Pool_recycles_temporaries) {
+  Matrix A(8, 8);
+  for (int i = 0; i < 8; ++i) {
+    A(i, i) = 2;
+  }
+  memory::PoolResource pool;
+  {
+    memory::ScopedResource scope(&pool);
+    Matrix B = A * A + A;
+    ASSERT_EQ(B.GetResource(), &pool);
+    ASSERT_EQ(B(3, 3), 6);
+    B = (A * A).Transpose() + B;
+    const std::size_t blocks = pool.GetBlockCount();
+    for (int k = 0; k < 10; ++k) {
+      B = (A * A).Transpose() + B;
+    }
+    ASSERT_EQ(pool.GetBlockCount(), blocks);
+    ASSERT_EQ(B(3, 3), 50);
+  }
+  Matrix C(8, 8);
+  ASSERT_EQ(C.GetResource(), memory::GetResource());
+  ASSERT_NE(C.GetResource(), &pool);
+}
+
+TEST(TestMemory, Arena_and_nested_scopes) {
+  memory::ArenaResource arena(256);
+  memory::PoolResource pool;
+  {
+    memory::ScopedResource outer(&arena);
+    Matrix A(5, 5);
+    {
+      memory::ScopedResource inner(&pool);
+      Matrix B(A);
+      ASSERT_EQ(B.GetResource(), &pool);
+      // A moved matrix keeps the resource its buffer came from.
+      Matrix C(std::move(A));
+      ASSERT_EQ(C.GetResource(), &arena);
+      ASSERT_EQ(A.GetResource(), nullptr);
+    }
+    Matrix D(100, 100);
+    D(99, 99) = 1;
+    ASSERT_EQ(D.GetResource(), &arena);
+    ASSERT_GE(arena.GetUsed(), 100 * 100 * sizeof(double));
+  }
+  arena.Release();
+  ASSERT_EQ(arena.GetUsed(), 0u);
+}
+
+TEST(TestMemory, Small_matrices_are_inline) {
+  memory::PoolResource pool;
+  memory::ScopedResource scope(&pool);
+  Matrix A(4, 4);
+  for (int k = 0; k < 16; ++k) {
+    A(k / 4, k % 4) = k;
+  }
+  Matrix B(A);
+  Matrix C(std::move(B));
+  Matrix D(5, 5);
+  D = C;
+  Matrix E(2, 8);
+  std::swap(D, E);
+  ASSERT_EQ(pool.GetBlockCount(), 1u);
+  ASSERT_EQ(C, A);
+  ASSERT_EQ(E, A);
+  ASSERT_EQ(D.GetRows(), 2);
+  ASSERT_EQ(D(1, 7), 0);
+  ASSERT_EQ(B.GetRows(), 0);
+  ASSERT_EQ(B.GetResource(), nullptr);
+  ASSERT_NE(C.Data(), A.Data());
+
+  // Swapping two inline matrices of different sizes.
+  Matrix G(1, 3);
+  G(0, 2) = 7;
+  std::swap(G, D);
+  ASSERT_EQ(G.GetCols(), 8);
+  ASSERT_EQ(D.GetCols(), 3);
+  ASSERT_EQ(D(0, 2), 7);
+
+  Matrix F = A * A;
+  F.SetRows(8);
+  F(7, 3) = 1;
+  F.SetRows(2);
+  ASSERT_EQ(F(1, 0), A(1, 0) * A(0, 0) + A(1, 1) * A(1, 0) +
+                         A(1, 2) * A(2, 0) + A(1, 3) * A(3, 0));
+}
+
+namespace {
+
+Matrix Filled(int rows, int cols, double value) {
+  Matrix result(rows, cols);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      result(i, j) = value + i - j;
+    }
+  }
+  return result;
+}
+
+ComplexMatrix ComplexFilled(int rows, int cols, double value) {
+  ComplexMatrix result(rows, cols);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      result(i, j) = {value + i - j, (i * 7 + j * 3) % 5 - 2.0};
+    }
+  }
+  return result;
+}
+
+// Conjugate transpose, which ComplexMatrix::Transpose() does not do.
+ComplexMatrix Adjoint(const ComplexMatrix& matrix) {
+  ComplexMatrix result = matrix.Transpose();
+  for (int i = 0; i < result.GetRows(); ++i) {
+    for (int j = 0; j < result.GetCols(); ++j) {
+      result(i, j) = std::conj(result(i, j));
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(TestRvalue, Operands_reuse_buffers) {
+  memory::PoolResource pool;
+  memory::ScopedResource scope(&pool);
+  Matrix A = Filled(6, 6, 1);
+  Matrix B = Filled(6, 6, 2);
+  const std::size_t blocks = pool.GetBlockCount();
+
+  Matrix C = Filled(6, 6, 1) + Filled(6, 6, 2);
+  Matrix D = A - Filled(6, 6, 2);
+  Matrix E = (A + B) - Filled(6, 6, 3);
+  Matrix F = 2 * Filled(6, 6, 1) * 3;
+  ASSERT_EQ(pool.GetBlockCount(), blocks + 4);
+
+  ASSERT_EQ(C, A + B);
+  ASSERT_EQ(D, A - B);
+  ASSERT_EQ(E, Filled(6, 6, 0));
+  ASSERT_EQ(F, A * 6);
+
+  const double* data = C.Data();
+  Matrix G = std::move(C) - A;
+  ASSERT_EQ(G.Data(), data);
+  ASSERT_EQ(G, B);
+  Matrix H = B - std::move(G);
+  ASSERT_EQ(H.Data(), data);
+  ASSERT_EQ(H, Matrix(6, 6));
+}
+
+TEST(TestRvalue, Different_dimensions) {
+  Matrix A(2, 3);
+  try {
+    Matrix B = A - Matrix(3, 2);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+  try {
+    Matrix B = Matrix(3, 2) + A;
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+}
+
+TEST(TestGemm, Transpose_flags_and_beta) {
+  for (int size : {3, 70}) {
+    Matrix A = Filled(size, size + 5, 0.5);
+    Matrix B = Filled(size + 5, size - 1, -1);
+    Matrix At = A.Transpose();
+    Matrix Bt = B.Transpose();
+    Matrix expected = A * B * 2;
+    Matrix C = Filled(size, size - 1, 3);
+    Matrix C0 = C;
+
+    Gemm(2.0, A, false, B, false, 0.0, C);
+    ASSERT_EQ(C, expected);
+    C = C0;
+    Gemm(2.0, At, true, B, false, 1.0, C);
+    ASSERT_EQ(C, expected + C0);
+    C = C0;
+    Gemm(2.0, A, false, Bt, true, -1.0, C);
+    ASSERT_EQ(C, expected - C0);
+    C = C0;
+    Gemm(2.0, At, true, Bt, true, 0.5, C);
+    C0.MulNumber(0.5);
+    ASSERT_EQ(C, expected + C0);
+  }
+}
+
+TEST(TestGemm, Loop_does_not_allocate) {
+  // One thread, so that the packing buffers of every thread taking part
+  // have grown during the first round.
+  threads::SetNumThreads(1);
+  Matrix A = Filled(150, 300, 0.5);
+  Matrix B = Filled(300, 90, 1);
+  Matrix C(150, 90);
+  Matrix D(90, 150);
+  Matrix E = Filled(90, 90, 1);
+  // Matrix temporaries come from the scoped resource and packing buffers
+  // from the default one.
+  std::pmr::memory_resource* previous =
+      std::pmr::set_default_resource(&counting_resource);
+  long before = 0;
+  long after = 0;
+  {
+    memory::ScopedResource scope(&counting_resource);
+    Gemm(1.0, A, false, B, false, 0.0, C);
+    Gemm(1.0, B, true, A, true, 0.0, D);
+    before = counting_resource.GetAllocations();
+    for (int round = 0; round < 5; ++round) {
+      Gemm(1.0, A, false, B, false, 0.5, C);
+      Gemm(2.0, B, true, A, true, 1.0, D);
+      Gemm(1.0, MatrixView(A).Block(10, 20, 100, 200), false,
+           MatrixView(B).Block(30, 0, 200, 80), false, 0.0,
+           MatrixView(C).Block(0, 5, 100, 80));
+    }
+    after = counting_resource.GetAllocations();
+    // An aliased operand is copied, which the resource does see.
+    Gemm(1.0, E, false, E, false, 0.0, E);
+  }
+  std::pmr::set_default_resource(previous);
+  threads::SetNumThreads(0);
+  ASSERT_EQ(after, before);
+  ASSERT_GT(counting_resource.GetAllocations(), after);
+}
+
+TEST(TestGemm, Aliasing_and_errors) {
+  Matrix A = Filled(4, 4, 1);
+  Matrix expected = A * A;
+  Gemm(1, A, false, A, false, 0, A);
+  ASSERT_EQ(A, expected);
+
+  Matrix B(4, 3);
+  Matrix C(4, 4);
+  try {
+    Gemm(1.0, A, false, B, true, 0.0, C);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ(
+        "The number of columns of the first matrix is not equal to the "
+        "number of rows of the second matrix.",
+        ex.what());
+  }
+  try {
+    Gemm(1.0, A, false, B, false, 0.0, C);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+}
+
+TEST(TestSparse, Builder_and_conversions) {
+  SparseMatrix::Builder builder(3, 4);
+  builder.Add(2, 3, 5);
+  builder.Add(0, 1, 1);
+  builder.Add(2, 0, -2);
+  builder.Add(0, 1, 2);
+  SparseMatrix S = builder.Build();
+  ASSERT_EQ(S.GetNonZeros(), 3);
+  ASSERT_EQ(S.GetRowOffsets(), std::vector<int>({0, 1, 1, 3}));
+  ASSERT_EQ(S.GetColumns(), std::vector<int>({1, 0, 3}));
+  ASSERT_EQ(S(0, 1), 3);
+  ASSERT_EQ(S(1, 1), 0);
+
+  Matrix D = static_cast<Matrix>(S);
+  ASSERT_EQ(D(2, 0), -2);
+  D(1, 2) = kEpsilon / 2;
+  SparseMatrix R(D);
+  ASSERT_EQ(R.GetNonZeros(), 3);
+  ASSERT_EQ(static_cast<Matrix>(R.Transpose()),
+            static_cast<Matrix>(S).Transpose());
+  ASSERT_EQ(R.Transpose().GetColumns(), std::vector<int>({2, 0, 2}));
+
+  try {
+    builder.Add(3, 0, 1);
+    FAIL();
+  } catch (std::out_of_range& ex) {
+    EXPECT_STREQ("Index out of range.", ex.what());
+  }
+}
+
+TEST(TestSparse, Products_match_dense) {
+  const int n = 3000;
+  SparseMatrix::Builder builder(n, n);
+  for (int i = 0; i < n; ++i) {
+    builder.Add(i, i, 4);
+    builder.Add(i, (i * 7 + 3) % n, -1);
+    builder.Add((i * 13 + 5) % n, i, 0.5);
+  }
+  SparseMatrix S = builder.Build();
+  std::vector<double> x(n);
+  for (int i = 0; i < n; ++i) {
+    x[i] = (i % 17) - 8;
+  }
+  std::vector<double> y = S * x;
+  const std::vector<int>& offsets = S.GetRowOffsets();
+  for (int i = 0; i < n; i += 97) {
+    double expected = 0;
+    for (int k = offsets[i]; k < offsets[i + 1]; ++k) {
+      expected += S.GetValues()[k] * x[S.GetColumns()[k]];
+    }
+    ASSERT_NEAR(y[i], expected, kEpsilon);
+  }
+
+  Matrix small = static_cast<Matrix>(SparseMatrix(Filled(40, 30, 0)));
+  Matrix B = Filled(30, 12, 1);
+  ASSERT_EQ(SparseMatrix(small) * B, small * B);
+  threads::SetNumThreads(4);
+  Matrix X = Filled(n, 16, 2);
+  Matrix P = S * X;
+  threads::SetNumThreads(1);
+  ASSERT_EQ(P, S * X);
+  try {
+    S * B;
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ(
+        "The number of columns of the first matrix is not equal to the "
+        "number of rows of the second matrix.",
+        ex.what());
+  }
+  threads::SetNumThreads(0);
+}
+
+TEST(TestBatch, Matches_per_matrix_operations) {
+  for (int n = 3; n <= 8; ++n) {
+    const int count = 300 + n;
+    MatrixBatch batch(count, n, n);
+    MatrixBatch rhs(count, n, 2);
+    for (int b = 0; b < count; ++b) {
+      for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+          batch(b, i, j) = ((b * 31 + i * 7 + j * 3) % 19) - 9 + (i == j);
+        }
+        rhs(b, i, 0) = i - b % 5;
+        rhs(b, i, 1) = 1;
+      }
+    }
+    std::vector<double> det = batch.Determinant();
+    MatrixBatch inverse = batch.InverseMatrix();
+    MatrixBatch product = batch * inverse;
+    MatrixBatch solution = batch.Solve(rhs);
+    for (int b = 0; b < count; b += 13) {
+      Matrix A = batch.Get(b);
+      ASSERT_NEAR(det[b], A.Determinant(), 1.0E-6 * std::fabs(det[b]));
+      ASSERT_EQ(inverse.Get(b), A.InverseMatrix());
+      ASSERT_EQ(A * solution.Get(b), rhs.Get(b));
+      Matrix I(n, n);
+      for (int i = 0; i < n; ++i) {
+        I(i, i) = 1;
+      }
+      ASSERT_EQ(product.Get(b), I);
+    }
+  }
+}
+
+TEST(TestBatch, Errors) {
+  MatrixBatch batch(4, 2, 2);
+  batch.Set(0, Matrix(2, 2));
+  ASSERT_EQ(batch.Determinant()[0], 0);
+  try {
+    batch.InverseMatrix();
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("The matrix determinant is 0.", ex.what());
+  }
+  try {
+    MatrixBatch(4, 2, 3).Determinant();
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("The matrix is not square.", ex.what());
+  }
+  try {
+    batch * MatrixBatch(3, 2, 2);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+  try {
+    batch(4, 0, 0);
+    FAIL();
+  } catch (std::out_of_range& ex) {
+    EXPECT_STREQ("Index out of range.", ex.what());
+  }
+  try {
+    MatrixBatch(INT_MAX, INT_MAX, INT_MAX);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Matrix too large.", ex.what());
+  }
+}
+
+TEST(TestGemm, Strassen_matches_classical) {
+  Matrix A = Filled(67, 45, 0.25);
+  Matrix B = Filled(45, 51, -0.5);
+  A(3, 7) = 11;
+  B(44, 50) = -3;
+  Matrix expected = A * B;
+  Matrix square = Filled(64, 64, 1);
+  Matrix square_expected = square * square;
+
+  ASSERT_EQ(gemm::GetAlgorithm(), gemm::Algorithm::kClassical);
+  gemm::SetAlgorithm(gemm::Algorithm::kStrassen);
+  gemm::SetStrassenCrossover(1);
+  ASSERT_EQ(gemm::GetStrassenCrossover(), gemm::kMinStrassenCrossover);
+  Matrix C = A * B;
+  Matrix D = square * square;
+  Matrix E = Filled(67, 51, 2);
+  Gemm(-2.0, A, false, B, false, 1.0, E);
+  // The workspace comes from the scoped resource and goes back to it.
+  memory::PoolResource pool;
+  {
+    memory::ScopedResource scope(&pool);
+    Gemm(-2.0, A, false, B, false, 1.0, E);
+    Gemm(2.0, A, false, B, false, 1.0, E);
+  }
+  ASSERT_EQ(pool.GetBlockCount(), 1u);
+  gemm::SetStrassenCrossover(gemm::kDefaultStrassenCrossover);
+  gemm::SetAlgorithm(gemm::Algorithm::kClassical);
+
+  ASSERT_EQ(C, expected);
+  ASSERT_EQ(D, square_expected);
+  ASSERT_EQ(E, Filled(67, 51, 2) - expected * 2);
+}
+
+TEST(TestView, Slices_share_storage) {
+  Matrix A = Filled(5, 6, 0);
+  MatrixView block = MatrixView(A).Block(1, 2, 3, 3);
+  ASSERT_EQ(block.GetRows(), 3);
+  ASSERT_EQ(block.GetStride(), 6);
+  ASSERT_EQ(block(0, 0), A(1, 2));
+  block(2, 1) = 42;
+  ASSERT_EQ(A(3, 3), 42);
+
+  ConstMatrixView row = ConstMatrixView(A).Row(4);
+  ConstMatrixView col = ConstMatrixView(A).Col(5);
+  ASSERT_EQ(row.GetCols(), 6);
+  ASSERT_EQ(col.GetRows(), 5);
+  ASSERT_EQ(row(0, 5), A(4, 5));
+  ASSERT_EQ(col(4, 0), A(4, 5));
+
+  Matrix copy = block;
+  ASSERT_EQ(copy(2, 1), 42);
+  ASSERT_EQ(block.Transpose(), copy.Transpose());
+  ASSERT_DOUBLE_EQ(block.Determinant(), copy.Determinant());
+  Matrix large = Filled(100, 80, 0.5);
+  ConstMatrixView strided = ConstMatrixView(large).Block(20, 7, 70, 45);
+  ASSERT_EQ(strided.Transpose(), Matrix(strided).Transpose());
+
+  block.Assign(Filled(3, 3, 1));
+  block += block;
+  block *= 0.5;
+  ASSERT_EQ(Matrix(block), Filled(3, 3, 1));
+  MatrixView(A).Row(0) -= ConstMatrixView(A).Row(1);
+  ASSERT_EQ(A(0, 0), -1);
+  ASSERT_EQ(A(0, 3), -3);
+
+  Matrix B = block + Filled(3, 3, 1) - ConstMatrixView(A).Block(2, 0, 3, 3);
+  ASSERT_EQ(B(0, 0), Filled(3, 3, 1)(0, 0) * 2 - A(2, 0));
+
+  try {
+    MatrixView(A).Block(3, 0, 3, 1);
+    FAIL();
+  } catch (std::out_of_range& ex) {
+    EXPECT_STREQ("Index out of range.", ex.what());
+  }
+  try {
+    block += Matrix(2, 3);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+}
+
+TEST(TestView, Gemm_on_blocks) {
+  Matrix A = Filled(40, 50, 0.5);
+  Matrix B = Filled(50, 30, -1);
+  Matrix C = Filled(40, 30, 2);
+  ConstMatrixView a = ConstMatrixView(A).Block(3, 4, 20, 25);
+  ConstMatrixView b = ConstMatrixView(B).Block(5, 1, 25, 17);
+  MatrixView c = MatrixView(C).Block(10, 6, 20, 17);
+  Matrix expected = C;
+  MatrixView(expected).Block(10, 6, 20, 17).Assign(
+      Matrix(c) * 3 + Matrix(a) * Matrix(b) * 2);
+
+  Gemm(2.0, a, false, b, false, 3.0, c);
+  ASSERT_EQ(C, expected);
+
+  Matrix At = Matrix(a).Transpose();
+  ConstMatrixView b_top = ConstMatrixView(B).Block(0, 0, 25, 17);
+  Gemm(1.0, At, true, b_top, false, 0.0, c);
+  ASSERT_EQ(Matrix(c), Matrix(a) * Matrix(b_top));
+
+  Matrix D = Filled(6, 6, 1);
+  Matrix top = Matrix(ConstMatrixView(D).Block(0, 0, 3, 6));
+  Matrix expected_d = D;
+  MatrixView(expected_d).Block(3, 0, 3, 6).Assign(top * D);
+  Gemm(1.0, MatrixView(D).Block(0, 0, 3, 6), false, D, false, 0.0,
+       MatrixView(D).Block(3, 0, 3, 6));
+  ASSERT_EQ(D, expected_d);
+}
+
+TEST(TestIo, Save_load_and_map) {
+  const std::string path = ::testing::TempDir() + "matrix_io_test.bin";
+  Matrix A = Filled(37, 21, 0.25);
+  A(5, 7) = 1e300;
+  io::Save(A, path);
+  ASSERT_EQ(io::Load<double>(path), A);
+
+  io::MappedMatrix mapped(path);
+  ASSERT_EQ(mapped.GetRows(), 37);
+  ASSERT_EQ(mapped.GetCols(), 21);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(mapped.Data()) %
+                io::kFileAlignment,
+            0u);
+  ASSERT_EQ(Matrix(mapped.View()), A);
+  io::MappedMatrix moved = std::move(mapped);
+  ASSERT_EQ(mapped.Data(), nullptr);
+  ASSERT_EQ(moved.View()(5, 7), 1e300);
+
+  ComplexMatrix C(2, 3);
+  C(1, 2) = {1.5, -2};
+  io::Save(C, path);
+  ASSERT_EQ(io::Load<std::complex<double>>(path), C);
+  ASSERT_EQ(io::ComplexMappedMatrix(path).View()(1, 2), C(1, 2));
+
+  io::Save(Matrix(), path);
+  ASSERT_EQ(io::Load<double>(path).GetRows(), 0);
+  std::remove(path.c_str());
+}
+
+TEST(TestIo, Errors) {
+  const std::string path = ::testing::TempDir() + "matrix_io_errors.bin";
+  io::Save(FloatMatrix(3, 3), path);
+  try {
+    io::Load<double>(path);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different element types.", ex.what());
+  }
+  // A header whose dimensions multiply past INT_MAX elements, in a sparse
+  // file of exactly the announced length. Offset 32 holds rows, 40 cols.
+  io::Save(FloatMatrix(2, 2), path);
+  std::FILE* file = std::fopen(path.c_str(), "r+b");
+  const std::int64_t huge[2] = {1 << 16, (1 << 15) + 1};
+  std::fseek(file, 32, SEEK_SET);
+  std::fwrite(huge, sizeof(huge), 1, file);
+  std::fclose(file);
+  ASSERT_EQ(::truncate(path.c_str(), 64 + huge[0] * huge[1] * sizeof(float)),
+            0);
+  EXPECT_THROW(io::Load<float>(path), std::invalid_argument);
+  EXPECT_THROW(io::FloatMappedMatrix mapped(path), std::invalid_argument);
+  // A file cut short of the elements its header announces.
+  io::Save(Filled(10, 10, 0), path);
+  ASSERT_EQ(::truncate(path.c_str(), 64 + 99 * sizeof(double)), 0);
+  EXPECT_THROW(io::Load<double>(path), std::invalid_argument);
+  EXPECT_THROW(io::MappedMatrix mapped(path), std::invalid_argument);
+
+  file = std::fopen(path.c_str(), "r+b");
+  std::fputs("garbage", file);
+  std::fclose(file);
+  try {
+    io::MappedMatrix mapped(path);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Invalid matrix file.", ex.what());
+  }
+  std::remove(path.c_str());
+  EXPECT_THROW(io::Load<double>(path), std::system_error);
+}
+
+TEST(TestIo, Out_of_core_multiply) {
+  const std::string a_path = ::testing::TempDir() + "matrix_ooc_a.bin";
+  const std::string b_path = ::testing::TempDir() + "matrix_ooc_b.bin";
+  const std::string c_path = ::testing::TempDir() + "matrix_ooc_c.bin";
+  Matrix A = Filled(70, 45, 0.5);
+  Matrix B = Filled(45, 33, -2);
+  A(69, 44) = 7;
+  io::Save(A, a_path);
+  io::Save(B, b_path);
+  Matrix expected = A * B;
+
+  // 16 x 16 tiles, with partial tiles along every dimension.
+  io::MultiplyFiles<double>(a_path, b_path, c_path, 5 * 16 * 16 * 8);
+  ASSERT_EQ(io::Load<double>(c_path), expected);
+  io::MultiplyFiles<double>(a_path, b_path, c_path, 1 << 30);
+  ASSERT_EQ(io::Load<double>(c_path), expected);
+
+  try {
+    io::MultiplyFiles<double>(a_path, b_path, c_path, 39);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Memory budget too small.", ex.what());
+  }
+  try {
+    io::MultiplyFiles<double>(a_path, a_path, c_path, 1 << 20);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ(
+        "The number of columns of the first matrix is not equal to the "
+        "number of rows of the second matrix.",
+        ex.what());
+  }
+  // An input passed as the output, also under another name, is left intact.
+  const std::string alias = ::testing::TempDir() + "matrix_ooc_alias.bin";
+  std::remove(alias.c_str());
+  ASSERT_EQ(::link(b_path.c_str(), alias.c_str()), 0);
+  for (const std::string& output : {a_path, alias}) {
+    try {
+      io::MultiplyFiles<double>(a_path, b_path, output, 1 << 20);
+      FAIL();
+    } catch (std::invalid_argument& ex) {
+      EXPECT_STREQ("The output file is an input file.", ex.what());
+    }
+  }
+  ASSERT_EQ(io::Load<double>(a_path), A);
+  ASSERT_EQ(io::Load<double>(b_path), B);
+  std::remove(alias.c_str());
+  std::remove(a_path.c_str());
+  std::remove(b_path.c_str());
+  std::remove(c_path.c_str());
+}
+
+TEST(TestIo, Text_read_and_write) {
+  std::istringstream csv("1, 2.5,-3e2\r\n\n  +4,5,6\n7,8,9");
+  Matrix A = io::ReadText<double>(csv);
+  ASSERT_EQ(A.GetRows(), 3);
+  ASSERT_EQ(A.GetCols(), 3);
+  ASSERT_EQ(A(0, 2), -300);
+  ASSERT_EQ(A(1, 0), 4);
+  ASSERT_EQ(A(2, 2), 9);
+
+  std::istringstream blanks("\t1 2\n3\t  4 \n");
+  FloatMatrix B = io::ReadText<float>(blanks, ' ');
+  ASSERT_EQ(B.GetRows(), 2);
+  ASSERT_EQ(B(1, 1), 4.0f);
+
+  Matrix C = Filled(300, 17, 0.1);
+  C(7, 3) = 1.0 / 3;
+  C(9, 1) = -1e-300;
+  for (char delimiter : {',', ' '}) {
+    std::stringstream text;
+    io::WriteText(C, text, delimiter);
+    Matrix D = io::ReadText<double>(text, delimiter);
+    ASSERT_EQ(D.GetRows(), 300);
+    ASSERT_EQ(std::memcmp(D.Data(), C.Data(), 300 * 17 * sizeof(double)), 0);
+  }
+
+  for (const char* bad : {"1,2\n3,x", "1,,2", "1,2,", "1-2 3", "1;2"}) {
+    std::istringstream in(bad);
+    try {
+      io::ReadText<double>(in);
+      FAIL() << bad;
+    } catch (std::invalid_argument& ex) {
+      EXPECT_STREQ("Invalid matrix text.", ex.what());
+    }
+  }
+  std::istringstream ragged("1,2\n3,4,5\n");
+  try {
+    io::ReadText<double>(ragged);
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+}
+
+TEST(TestMutator, Reserve_rows) {
+  Matrix A = Filled(10, 4, 1);
+  A.ReserveRows(100);
+  const double* data = A.Data();
+  ASSERT_EQ(A, Filled(10, 4, 1));
+  A.SetRows(3);
+  A.SetRows(60);
+  ASSERT_EQ(A.Data(), data);
+  ASSERT_EQ(A(2, 3), Filled(10, 4, 1)(2, 3));
+  ASSERT_EQ(A(5, 0), 0);
+  A.SetRows(101);
+  ASSERT_NE(A.Data(), data);
+  ASSERT_EQ(A(0, 0), 1);
+  EXPECT_THROW(A.ReserveRows(-1), std::invalid_argument);
+}
+
+TEST(TestSolve, Lu_solve) {
+  for (int size : {4, 150}) {
+    Matrix A = Filled(size, size, 0.5);
+    for (int i = 0; i < size; ++i) A(i, i) += size;
+    Matrix B = Filled(size, 3, 1);
+    Matrix X = Solve(A, B);
+    ASSERT_EQ(A * X, B);
+    LuFactor lu = A.Lu();
+    ASSERT_EQ(lu.Solve(B * 2), X * 2);
+  }
+  // Singularity is judged relative to the largest pivot, not to a fixed
+  // threshold.
+  Matrix tiny(3, 3);
+  for (int i = 0; i < 3; ++i) tiny(i, i) = 1e-9;
+  Matrix x = Filled(3, 2, 4);
+  ASSERT_EQ(Solve(tiny, Matrix(tiny * x)), x);
+  ASSERT_FALSE(tiny.Lu().IsSingular());
+  Matrix identity(3, 3);
+  for (int i = 0; i < 3; ++i) identity(i, i) = 1;
+  ASSERT_EQ(tiny.InverseMatrix() * tiny, identity);
+  Matrix nearly = Filled(3, 3, 1);
+  nearly(2, 2) += 1e-12;
+  nearly.MulNumber(1e6);
+  ASSERT_TRUE(nearly.Lu().IsSingular());
+  EXPECT_THROW(Solve(nearly, Matrix(3, 1)), std::invalid_argument);
+  EXPECT_THROW(nearly.InverseMatrix(), std::invalid_argument);
+  // An empty system has an empty solution.
+  Matrix empty = Matrix().Lu().Solve(Matrix(0, 2));
+  ASSERT_EQ(empty.GetRows(), 0);
+  ASSERT_EQ(empty.GetCols(), 2);
+  try {
+    Solve(Matrix(3, 3), Matrix(3, 1));
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("The matrix determinant is 0.", ex.what());
+  }
+  try {
+    Filled(3, 3, 5).Lu().Solve(Matrix(2, 1));
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Different matrix dimensions.", ex.what());
+  }
+}
+
+TEST(TestSolve, Cholesky_spd) {
+  for (int size : {1, 5, 150}) {
+    Matrix R = Filled(size, size, 0.25);
+    Matrix A = R.Transpose() * R;
+    for (int i = 0; i < size; ++i) A(i, i) += 1;
+    CholeskyFactor cholesky(A);
+    const Matrix& U = cholesky.GetU();
+    ASSERT_EQ(U.Transpose() * U, A);
+    ASSERT_EQ(U(size - 1, 0), size > 1 ? 0 : U(0, 0));
+    Matrix B = Filled(size, 4, -1);
+    Matrix X = SolveSpd(A, B);
+    ASSERT_EQ(A * X, B);
+    ASSERT_EQ(cholesky.Solve(B), X);
+    ASSERT_NEAR(cholesky.Determinant() / A.Determinant(), 1, 1e-7);
+  }
+
+  ComplexMatrix H(2, 2);
+  H(0, 0) = 4;
+  H(0, 1) = {1, 2};
+  H(1, 0) = {1, -2};
+  H(1, 1) = 6;
+  ComplexMatrix b(2, 1);
+  b(0, 0) = {1, 1};
+  b(1, 0) = 2;
+  ASSERT_EQ(H * SolveSpd(H, b), b);
+
+  // Several panels, so the conjugated panel staging and the parallel block
+  // row updates are exercised.
+  threads::SetNumThreads(3);
+  ComplexMatrix Z = ComplexFilled(130, 130, 0.25);
+  ComplexMatrix G = Adjoint(Z) * Z;
+  for (int i = 0; i < 130; ++i) G(i, i) += 1;
+  BasicCholeskyFactor<std::complex<double>> hermitian(G);
+  const ComplexMatrix& V = hermitian.GetU();
+  ASSERT_EQ(Adjoint(V) * V, G);
+  ASSERT_EQ(V(129, 0), 0.0);
+  ComplexMatrix rhs = ComplexFilled(130, 3, -1);
+  ASSERT_EQ(G * SolveSpd(G, rhs), rhs);
+  threads::SetNumThreads(0);
+
+  try {
+    CholeskyFactor factor(Filled(3, 3, 0));
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("The matrix is not positive definite.", ex.what());
+  }
+  // Pivots are judged relative to the largest diagonal entry: a uniformly
+  // tiny matrix factors, a semidefinite one with a tiny pivot does not.
+  Matrix scaled(2, 2);
+  scaled(0, 0) = 2e-300;
+  scaled(0, 1) = 1e-300;
+  scaled(1, 0) = 1e-300;
+  scaled(1, 1) = 2e-300;
+  ASSERT_NEAR(CholeskyFactor(scaled).GetU()(0, 0), std::sqrt(2e-300), 1e-160);
+  Matrix semidefinite(2, 2);
+  semidefinite(0, 0) = 1;
+  semidefinite(1, 1) = 1e-300;
+  EXPECT_THROW(CholeskyFactor{semidefinite}, std::invalid_argument);
+  try {
+    SolveSpd(Matrix(2, 3), Matrix(2, 1));
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("The matrix is not square.", ex.what());
+  }
+}
+
+TEST(TestQr, Factorization_shapes) {
+  for (auto shape : {std::pair<int, int>{5, 3}, {3, 5}, {150, 70}, {70, 150},
+                     {300, 130}}) {
+    Matrix A = Filled(shape.first, shape.second, 0.5);
+    for (int i = 0; i < std::min(shape.first, shape.second); ++i) {
+      A(i, i) += 3 + i % 5;
+    }
+    QrFactor qr(A);
+    Matrix Q = qr.GetQ();
+    Matrix R = qr.GetR();
+    const int k = std::min(shape.first, shape.second);
+    ASSERT_EQ(Q.GetCols(), k);
+    ASSERT_EQ(R.GetRows(), k);
+    ASSERT_EQ(Q * R, A);
+    Matrix I(k, k);
+    for (int i = 0; i < k; ++i) I(i, i) = 1;
+    ASSERT_EQ(Q.Transpose() * Q, I);
+    for (int i = 1; i < k; ++i) ASSERT_EQ(R(i, i - 1), 0);
+    Matrix B = Filled(shape.first, 2, 1);
+    Matrix C = qr.ApplyQAdjoint(B);
+    ASSERT_EQ(C.GetRows(), shape.first);
+    Matrix top(k, 2);
+    for (int i = 0; i < k; ++i) top(i, 0) = C(i, 0), top(i, 1) = C(i, 1);
+    ASSERT_EQ(top, Q.Transpose() * B);
+  }
+
+  // Columns whose squares overflow or underflow factor like the unscaled
+  // matrix: the reflector norms are accumulated with scaling.
+  Matrix A = Filled(40, 12, 0.5);
+  for (int i = 0; i < 12; ++i) A(i, i) += 3;
+  QrFactor reference(A);
+  for (int exponent : {530, -530}) {
+    Matrix scaled = A;
+    scaled.MulNumber(std::ldexp(1.0, exponent));
+    QrFactor qr(scaled);
+    Matrix R = qr.GetR();
+    R.MulNumber(std::ldexp(1.0, -exponent));
+    ASSERT_EQ(R, reference.GetR());
+    ASSERT_EQ(qr.GetQ(), reference.GetQ());
+  }
+}
+
+TEST(TestQr, Least_squares) {
+  // Overdetermined with an exact solution, then with a residual that must
+  // be orthogonal to the columns of A.
+  Matrix A = Filled(2000, 20, 0.25);
+  for (int i = 0; i < 20; ++i) A(i * 37, i) += 10;
+  Matrix x(20, 1);
+  for (int i = 0; i < 20; ++i) x(i, 0) = i - 7.5;
+  Matrix b = A * x;
+  ASSERT_EQ(LeastSquares(A, b), x);
+  Matrix noisy = b;
+  for (int i = 0; i < 2000; ++i) noisy(i, 0) += (i * 7919 % 13) - 6;
+  Matrix residual = A * LeastSquares(A, noisy) - noisy;
+  Matrix gradient = A.Transpose() * residual;
+  const double scale = (A.Transpose() * A)(0, 0);
+  for (int i = 0; i < 20; ++i) ASSERT_NEAR(gradient(i, 0) / scale, 0, 1e-12);
+
+  ComplexMatrix Z(3, 2);
+  Z(0, 0) = {1, 1};
+  Z(1, 0) = 2;
+  Z(2, 1) = {0, 3};
+  Z(1, 1) = {1, -1};
+  ComplexMatrix z(2, 1);
+  z(0, 0) = {2, -1};
+  z(1, 0) = {0.5, 4};
+  ASSERT_EQ(LeastSquares(Z, ComplexMatrix(Z * z)), z);
+  ComplexMatrix Q = BasicQrFactor<std::complex<double>>(Z).GetQ();
+  ComplexMatrix R = BasicQrFactor<std::complex<double>>(Z).GetR();
+  ASSERT_EQ(Q * R, Z);
+
+  // More columns than a panel, so the recursive panels, the conjugated GEMM
+  // products and the trailing updates all run on complex data.
+  ComplexMatrix W = ComplexFilled(300, 130, 0.5);
+  for (int i = 0; i < 130; ++i) W(i, i) += 4;
+  BasicQrFactor<std::complex<double>> complex_qr(W);
+  ComplexMatrix QW = complex_qr.GetQ();
+  ComplexMatrix identity(130, 130);
+  for (int i = 0; i < 130; ++i) identity(i, i) = 1;
+  ASSERT_EQ(QW * complex_qr.GetR(), W);
+  ASSERT_EQ(Adjoint(QW) * QW, identity);
+  ComplexMatrix w = ComplexFilled(130, 2, 1);
+  ASSERT_EQ(LeastSquares(W, ComplexMatrix(W * w)), w);
+
+  try {
+    LeastSquares(Matrix(2, 3), Matrix(2, 1));
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("Number of rows less than columns.", ex.what());
+  }
+  try {
+    LeastSquares(Filled(4, 2, 1) * 0, Matrix(4, 1));
+    FAIL();
+  } catch (std::invalid_argument& ex) {
+    EXPECT_STREQ("The matrix is rank deficient.", ex.what());
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();